@@ -0,0 +1,205 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Offline schedulability analysis (uniprocessor, per core)
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <string.h>
+
+#include "analysis.h"
+
+#define AN_MAX_ITER 1000000		// Bound on fixed point iterations
+#define AN_MAX_RES 16			// Distinct resources per core
+
+// Highest priority among the tasks of the core that use resource res
+static int AnCeiling(const struct an_task *t, int n, int core, const char *res)
+{
+	int i, k, ceil = -1;
+
+	for(i = 0; i < n; i++) {
+		if(t[i].core != core)
+			continue;
+		for(k = 0; k < t[i].ncs; k++)
+			if(!strcmp(t[i].cs[k].res, res) && t[i].prio > ceil)
+				ceil = t[i].prio;
+	}
+	return ceil;
+}
+
+// Worst-case blocking of task i caused by lower priority tasks of the same core
+uint64_t AnBlocking(const struct an_task *t, int n, int i, int protocol)
+{
+	const char *res[AN_MAX_RES];	// Resources that can block task i
+	uint64_t len[AN_MAX_RES];		// Their longest critical section
+	uint64_t B = 0;
+	int j, k, r, nres = 0;
+
+	for(j = 0; j < n; j++) {
+		if(t[j].core != t[i].core || t[j].prio >= t[i].prio || t[j].policy == AN_EDF)
+			continue; // AN_EDF: interference, not blocking
+		for(k = 0; k < t[j].ncs; k++) {
+			if(AnCeiling(t, n, t[i].core, t[j].cs[k].res) < t[i].prio)
+				continue; // Resource never blocks task i
+
+			for(r = 0; r < nres && strcmp(res[r], t[j].cs[k].res); r++);
+			if(r == nres) {
+				if(nres == AN_MAX_RES)
+					continue;
+				res[nres] = t[j].cs[k].res;
+				len[nres++] = 0;
+			}
+			if(t[j].cs[k].len > len[r])
+				len[r] = t[j].cs[k].len;
+		}
+	}
+
+	/* PCP: a single critical section. PIP: one critical section per resource */
+	for(r = 0; r < nres; r++) {
+		if(protocol == AN_PIP)
+			B += len[r];
+		else if(len[r] > B)
+			B = len[r];
+	}
+	return B;
+}
+
+// Task j preempts fixed priority task i of the core. Same priority: FIFO, worst case
+static int AnInterferes(const struct an_task *t, int i, int j, int core)
+{
+	if(j == i)
+		return 0;
+	if(t[j].policy == AN_EDF)
+		return 1; // SCHED_DEADLINE, on any core
+	return t[j].core == core && t[j].prio >= t[i].prio;
+}
+
+// Response time analysis of the fixed priority tasks of one core. Fills B and R. Returns the number of deadline misses
+int AnResponseTimes(struct an_task *t, int n, int core, int protocol)
+{
+	uint64_t R, Rn;
+	int i, j, iter, misses = 0;
+
+	for(i = 0; i < n; i++) {
+		if(t[i].core != core || t[i].policy == AN_EDF)
+			continue;
+
+		t[i].B = AnBlocking(t, n, i, protocol);
+		R = t[i].C + t[i].B;
+		for(iter = 0; iter < AN_MAX_ITER; iter++) {
+			Rn = t[i].C + t[i].B;
+			for(j = 0; j < n; j++)
+				if(AnInterferes(t, i, j, core))
+					Rn += ((R + t[j].J + t[j].T - 1) / t[j].T) * t[j].C;
+			if(Rn == R || Rn > t[i].D)
+				break;
+			R = Rn;
+		}
+
+		if(Rn > t[i].D || iter == AN_MAX_ITER) {
+			t[i].R = 0;
+			misses++;
+		} else
+			t[i].R = Rn;
+	}
+	return misses;
+}
+
+// Sum of C/T of the tasks of one core
+double AnUtilization(const struct an_task *t, int n, int core)
+{
+	double U = 0;
+	int i;
+
+	for(i = 0; i < n; i++)
+		if(t[i].core == core)
+			U += (double) t[i].C / t[i].T;
+	return U;
+}
+
+// Task j is covered by the demand test of the core: the AN_EDF tasks if there are any, otherwise all
+static int AnEdfTask(const struct an_task *t, int n, int j, int core)
+{
+	int i;
+
+	if(t[j].core != core)
+		return 0;
+	if(t[j].policy == AN_EDF)
+		return 1;
+	for(i = 0; i < n; i++)
+		if(t[i].core == core && t[i].policy == AN_EDF)
+			return 0;
+	return 1;
+}
+
+// Processor demand of the core in any interval of length L (synchronous release)
+static uint64_t AnDemand(const struct an_task *t, int n, int core, uint64_t L)
+{
+	uint64_t h = 0;
+	int j;
+
+	for(j = 0; j < n; j++)
+		if(AnEdfTask(t, n, j, core) && L + t[j].J >= t[j].D)
+			h += ((L + t[j].J - t[j].D) / t[j].T + 1) * t[j].C;
+	return h;
+}
+
+// SRP blocking for interval L: longest critical section of a task with relative deadline above L
+static uint64_t AnEdfBlocking(const struct an_task *t, int n, int core, uint64_t L)
+{
+	uint64_t B = 0;
+	int j, k;
+
+	for(j = 0; j < n; j++) {
+		if(!AnEdfTask(t, n, j, core) || t[j].D <= L)
+			continue;
+		for(k = 0; k < t[j].ncs; k++)
+			if(t[j].cs[k].len > B)
+				B = t[j].cs[k].len;
+	}
+	return B;
+}
+
+// EDF processor demand test of one core (AnEdfTask()). Returns 0 if schedulable, otherwise -1 and the failing interval in fail_L
+int AnEdfDemand(const struct an_task *t, int n, int core, uint64_t *fail_L)
+{
+	uint64_t busy = 0, w, L;
+	double U = 0;
+	int i, iter;
+
+	*fail_L = 0;
+	for(i = 0; i < n; i++)
+		if(AnEdfTask(t, n, i, core))
+			U += (double) t[i].C / t[i].T;
+	if(U > 1.0)
+		return -1;
+
+	/* Length of the synchronous busy period */
+	for(i = 0; i < n; i++)
+		if(AnEdfTask(t, n, i, core))
+			busy += t[i].C;
+	for(iter = 0; iter < AN_MAX_ITER; iter++) {
+		w = 0;
+		for(i = 0; i < n; i++)
+			if(AnEdfTask(t, n, i, core))
+				w += ((busy + t[i].J + t[i].T - 1) / t[i].T) * t[i].C;
+		if(w == busy)
+			break;
+		busy = w;
+	}
+
+	/* Check every absolute deadline inside the busy period */
+	for(i = 0; i < n; i++) {
+		if(!AnEdfTask(t, n, i, core))
+			continue;
+		for(L = t[i].D; L <= busy; L += t[i].T) {
+			if(AnDemand(t, n, core, L) + AnEdfBlocking(t, n, core, L) > L) {
+				*fail_L = L;
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,68 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Offline schedulability analysis (uniprocessor, per core)
+ *
+ *  - Fixed priorities: response time analysis with blocking,
+ *      R = C + B + sum_{hp} ceil((R+Jj)/Tj)*Cj
+ *    B follows the resource access protocol: priority ceiling (one
+ *    critical section of a lower priority task) or priority inheritance
+ *    (one critical section per resource).
+ *  - EDF: processor demand criterion, h(L) + B(L) <= L for every
+ *    absolute deadline L up to the synchronous busy period, with the
+ *    SRP blocking term B(L).
+ * Constrained deadlines (D <= T) are assumed. J is a jitter of the
+ * execution of a task: up to two C within any window of T - J (e.g. a
+ * deferrable server, J = period - budget). It adds to the interference
+ * and demand of the task on the others, not to its own response time.
+ * Tasks of policy AN_EDF (SCHED_DEADLINE) run ahead of every fixed
+ * priority task, on any core (their affinity is all the cores): the
+ * response time analysis counts all of them as higher priority
+ * interference, and on a core with AN_EDF tasks the demand test only
+ * covers those.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __ANALYSIS_H__
+#define __ANALYSIS_H__
+
+#include <stdint.h>
+
+#define AN_NAME_LEN 32
+#define AN_MAX_CS 4			// Critical sections per task
+
+/* Scheduling policies */
+#define AN_FP 0				// Fixed priorities (SCHED_FIFO/RR)
+#define AN_EDF 1			// SCHED_DEADLINE
+
+/* Resource access protocols (blocking terms) */
+#define AN_PCP 0			// Priority ceiling / SRP
+#define AN_PIP 1			// Priority inheritance
+
+struct an_cs {
+	char res[AN_NAME_LEN];	// Resource name
+	uint64_t len;			// Longest critical section (ns)
+};
+
+struct an_task {
+	char name[AN_NAME_LEN];
+	uint64_t C, T, D;		// WCET, period and relative deadline (ns)
+	uint64_t J;				// Jitter (ns), 0 for a periodic task
+	int prio;				// Higher value = higher priority
+	int policy;				// AN_FP or AN_EDF
+	int core;				// Core the task is pinned to
+	int ncs;
+	struct an_cs cs[AN_MAX_CS];
+	/* Results */
+	uint64_t B;				// Blocking term (ns)
+	uint64_t R;				// Worst-case response time (ns), 0 if R > D
+};
+
+uint64_t AnBlocking(const struct an_task *t, int n, int i, int protocol);
+int AnResponseTimes(struct an_task *t, int n, int core, int protocol);
+int AnEdfDemand(const struct an_task *t, int n, int core, uint64_t *fail_L);
+double AnUtilization(const struct an_task *t, int n, int core);
+
+#endif
@@ -0,0 +1,321 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Task graph (DAG) runtime: precedence and end-to-end latency
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+
+#include "dag.h"
+
+void DagInit(struct dag *g, const struct release_cfg *rel)
+{
+	memset(g, 0, sizeof(*g));
+	g->rel = *rel;
+}
+
+// Adds a node. period 0 makes it event-triggered. job NULL forwards the first input. Returns the node id or -1
+int DagAddNode(struct dag *g, const char *name, dag_job job, void *arg, const struct workload_cfg *load,
+	int prio, int cpu, nstime_t period, nstime_t offset)
+{
+	struct dag_node *n;
+	pthread_mutexattr_t mattr;
+
+	if(g->nnodes == DAG_MAX_NODES)
+		return -1;
+	n = &g->node[g->nnodes];
+	snprintf(n->name, DAG_NAME_LEN, "%s", name);
+	n->g = g;
+	n->job = job;
+	n->arg = arg;
+	WorkloadInit(&n->load, load, g->nnodes + 1);
+	n->prio = prio;
+	n->cpu = cpu;
+	n->period = period;
+	n->offset = offset;
+	ReleaseInit(&n->release, &g->rel);
+	HistInit(&n->exec);
+	HistInit(&n->latency);
+	HistInit(&n->age);
+
+	/* Priority inheritance: a low priority producer may hold the lock of a high priority consumer */
+	pthread_mutexattr_init(&mattr);
+	pthread_mutexattr_setprotocol(&mattr, PTHREAD_PRIO_INHERIT);
+	pthread_mutex_init(&n->lock, &mattr);
+	pthread_mutexattr_destroy(&mattr);
+	pthread_cond_init(&n->cv, NULL);
+	return g->nnodes++;
+}
+
+// Adds an edge from node from to node to. Returns the edge id or -1
+int DagAddEdge(struct dag *g, int from, int to)
+{
+	struct dag_node *n;
+
+	if(g->nedges == DAG_MAX_EDGES || from < 0 || from >= g->nnodes || to < 0 || to >= g->nnodes || from == to)
+		return -1;
+	n = &g->node[to];
+	if(n->nin == DAG_MAX_IN)
+		return -1;
+
+	g->edge[g->nedges].from = from;
+	g->edge[g->nedges].to = to;
+	n->in[n->nin++] = g->nedges;
+	g->node[from].nout++;
+	return g->nedges++;
+}
+
+// Takes the last message of every input. Event-triggered nodes wait until all of them are new.
+// Returns 0 if some input never got a message (time-triggered nodes only)
+static int DagRead(struct dag_node *n, struct dag_msg *in)
+{
+	struct dag *g = n->g;
+	int i, ready;
+
+	pthread_mutex_lock(&n->lock);
+	do {
+		ready = 1;
+		for(i = 0; i < n->nin; i++)
+			if(n->period > 0 ? g->edge[n->in[i]].msg.seq == 0 : !g->edge[n->in[i]].fresh)
+				ready = 0;
+		if(!ready && n->period > 0) {
+			pthread_mutex_unlock(&n->lock);
+			return 0;
+		}
+		if(!ready)
+			pthread_cond_wait(&n->cv, &n->lock);
+	} while(!ready);
+
+	for(i = 0; i < n->nin; i++) {
+		in[i] = g->edge[n->in[i]].msg;
+		g->edge[n->in[i]].fresh = 0;
+	}
+	pthread_mutex_unlock(&n->lock);
+	return 1;
+}
+
+// Sends a message on every output edge of node id
+static void DagSend(struct dag *g, int id, const struct dag_msg *m)
+{
+	struct dag_edge *e;
+	struct dag_node *to;
+	int i;
+
+	for(i = 0; i < g->nedges; i++) {
+		e = &g->edge[i];
+		if(e->from != id)
+			continue;
+		to = &g->node[e->to];
+		pthread_mutex_lock(&to->lock);
+		if(e->fresh)
+			e->lost++;
+		e->msg = *m;
+		e->fresh = 1;
+		pthread_cond_signal(&to->cv);
+		pthread_mutex_unlock(&to->lock);
+	}
+}
+
+// Merges in into m: source, instance and release of the oldest release, oldest sampling instant
+static void DagOldest(struct dag_msg *m, const struct dag_msg *in)
+{
+	if(in->release < m->release) {
+		m->src = in->src;
+		m->seq = in->seq;
+		m->release = in->release;
+	}
+	if(in->stamp < m->stamp)
+		m->stamp = in->stamp;
+}
+
+// Longest load of a node, with the signature of a warm-up job
+static void DagDry(void *arg)
+{
+	struct dag_node *n = (struct dag_node *) arg;
+
+	WorkloadRun(WorkloadMax(&n->load.cfg));
+}
+
+static void *DagThread(void *arg)
+{
+	struct dag_node *n = (struct dag_node *) arg;
+	struct dag *g = n->g;
+	struct dag_msg in[DAG_MAX_IN], m;
+	float v[DAG_MAX_IN], out;
+	nstime_t ts, tr = 0, ta, tf;
+	uint64_t seq = 0;
+	int i, send, id = n - g->node;
+
+	/* Warm-up, then wait for all the nodes and for DagStart() to set the start time */
+	WarmupThread(&n->warm);
+	WarmupWork(&n->warm, DagDry, n, WARMUP_MAX_RUNS);
+	pthread_barrier_wait(&g->barrier);
+	pthread_barrier_wait(&g->barrier);
+
+	ts = NsAdd(g->start, n->offset);
+	while(1) {
+		/* Activation: own period or new messages on every input */
+		if(n->period > 0) {
+			ReleaseWait(&n->release, ts);
+			tr = ts;
+			ts = NsAdd(ts, n->period);
+		}
+		if(!DagRead(n, in))
+			continue; // Time-triggered, inputs not produced yet
+		ta = NsNow(CLOCK_MONOTONIC);
+
+		/* Source data is stamped here, the other nodes forward the oldest input consumed since their last send */
+		if(n->nin == 0) {
+			m.src = id;
+			m.seq = ++seq;
+			m.release = tr;
+			m.stamp = ta;
+		} else {
+			m = in[0];
+			for(i = 1; i < n->nin; i++)
+				DagOldest(&m, &in[i]);
+			if(n->nheld++)
+				DagOldest(&m, &n->held);
+			n->held = m;
+		}
+
+		/* Do the actual processing */
+		for(i = 0; i < n->nin; i++)
+			v[i] = in[i].val;
+		out = n->nin ? v[0] : 0;
+		send = n->job ? n->job(v, n->nin, &out, n->arg) : 1;
+		WorkloadExec(&n->load);
+		tf = NsNow(CLOCK_MONOTONIC);
+		HistRecord(&n->exec, NsSubSat(tf, ta));
+		n->jobs++;
+
+		if(!send)
+			continue;
+		n->nheld = 0;
+		m.val = out;
+		if(n->nout > 0) {
+			DagSend(g, id, &m);
+		} else if(n->nin > 0) {
+			/* Sink: age of the data used, latency once per instance of the oldest source */
+			HistRecord(&n->age, NsSubSat(tf, m.stamp));
+			if(m.seq > n->last_seq[m.src])
+				HistRecord(&n->latency, NsSubSat(tf, m.release));
+			n->last_seq[m.src] = m.seq;
+		}
+	}
+	return NULL;
+}
+
+// Topological order of the edges into event-triggered nodes (the ones that wait for their inputs).
+// Returns the first node never released, on or after a cycle of event-triggered nodes, or -1 if none
+static int DagCycle(const struct dag *g)
+{
+	int wait[DAG_MAX_NODES], order[DAG_MAX_NODES];
+	int i, j, head = 0, tail = 0;
+
+	for(i = 0; i < g->nnodes; i++) {
+		wait[i] = g->node[i].period > 0 ? 0 : g->node[i].nin;
+		if(wait[i] == 0)
+			order[tail++] = i;
+	}
+	while(head < tail) {
+		i = order[head++];
+		for(j = 0; j < g->nedges; j++)
+			if(g->edge[j].from == i && wait[g->edge[j].to] > 0 && --wait[g->edge[j].to] == 0)
+				order[tail++] = g->edge[j].to;
+	}
+	for(i = 0; i < g->nnodes; i++)
+		if(wait[i] > 0)
+			return i;
+	return -1;
+}
+
+// Creates the node threads, waits for their warm-up and releases the graph. Returns 0 if Ok
+int DagStart(struct dag *g)
+{
+	struct dag_node *n;
+	struct sched_param parm;
+	pthread_attr_t attr;
+	cpu_set_t cpuset;
+	nstime_t warm_start;
+	int i, err;
+
+	for(i = 0; i < g->nnodes; i++) {
+		n = &g->node[i];
+		if(n->period == 0 && n->nin == 0) {
+			printf("DAG node %s: a node without inputs must be time-triggered (period > 0)\n\r", n->name);
+			return -1;
+		}
+	}
+	/* Event-triggered cycles deadlock: some node on the cycle must be time-triggered */
+	if((i = DagCycle(g)) >= 0) {
+		printf("DAG node %s: on or after a cycle of event-triggered nodes, it would never be released\n\r",
+			g->node[i].name);
+		return -1;
+	}
+
+	pthread_barrier_init(&g->barrier, NULL, g->nnodes + 1);
+	warm_start = NsNow(CLOCK_MONOTONIC);
+	for(i = 0; i < g->nnodes; i++) {
+		n = &g->node[i];
+		parm.sched_priority = n->prio;
+		pthread_attr_init(&attr);
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		pthread_attr_setschedparam(&attr, &parm);
+		if(n->cpu >= 0) {
+			CPU_ZERO(&cpuset);
+			CPU_SET(n->cpu, &cpuset);
+			pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpuset);
+		}
+		err = pthread_create(&n->thread, &attr, DagThread, n);
+		pthread_attr_destroy(&attr);
+		if(err != 0) {
+			printf("\n\r Error creating DAG node %s [%s]\n\r", n->name, strerror(err));
+			return -1;
+		}
+	}
+
+	/* All the offsets are relative to the same start time, set once every node is warm */
+	pthread_barrier_wait(&g->barrier);
+	printf("Warm-up of %d DAG nodes: %.3f ms\n\r", g->nnodes, NsSubSat(NsNow(CLOCK_MONOTONIC), warm_start) / 1e6);
+	for(i = 0; i < g->nnodes; i++)
+		WarmupPrint(&g->node[i].warm, g->node[i].name);
+	g->start = NsAdd(NsNow(CLOCK_MONOTONIC), DAG_START_DELAY_NS);
+	pthread_barrier_wait(&g->barrier);
+	return 0;
+}
+
+// Prints the statistics of every node and edge (not used in the real-time path)
+void DagPrint(const struct dag *g)
+{
+	const struct dag_node *n;
+	const struct dag_edge *e;
+	char label[80];
+	int i;
+
+	for(i = 0; i < g->nnodes; i++) {
+		n = &g->node[i];
+		printf("Node %s: %s / jobs: %lu\n\r", n->name, n->period > 0 ? "time-triggered" : "event-triggered", n->jobs);
+		snprintf(label, sizeof(label), "  %s execution time", n->name);
+		HistPrint(&n->exec, label);
+		if(n->nout == 0 && n->nin > 0) {
+			snprintf(label, sizeof(label), "  %s end-to-end latency", n->name);
+			HistPrint(&n->latency, label);
+			snprintf(label, sizeof(label), "  %s data age", n->name);
+			HistPrint(&n->age, label);
+		}
+		if(n->period > 0)
+			ReleasePrint(&n->release, n->name);
+	}
+	for(i = 0; i < g->nedges; i++) {
+		e = &g->edge[i];
+		printf("Edge %s -> %s: lost messages: %lu\n\r", g->node[e->from].name, g->node[e->to].name, e->lost);
+	}
+}
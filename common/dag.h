@@ -0,0 +1,117 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Task graph (DAG) runtime: precedence and end-to-end latency
+ *
+ * Nodes are jobs run by their own real-time thread, edges carry the
+ * messages between them (one slot per edge, a new message overwrites an
+ * unread one, which is counted as lost, like the x1/x2 globals of the
+ * lab3 acquisition chain). A node is
+ *  - time-triggered (period > 0): released periodically (release.h),
+ *    it reads the last message of each input edge. Sources (no inputs)
+ *    must be time-triggered: they release the whole graph.
+ *  - event-triggered (period 0): released when every input edge has a
+ *    new message (AND join). Every cycle of the graph needs a
+ *    time-triggered node, DagStart() rejects the others (deadlock).
+ * The node job transforms the input values into one output value, or
+ * sends nothing (e.g. a decimating filter), and then runs its synthetic
+ * load (workload.h).
+ *
+ * Each message carries the source node, the instance, the release time
+ * and the start time (sampling instant) of the source job it comes
+ * from. A node forwards the oldest of the inputs it consumed since its
+ * last send: across its inputs and across the jobs that sent nothing
+ * (e.g. the samples averaged by a decimating filter). At the sinks (no
+ * outputs):
+ *  - end-to-end latency: sink job end minus the release of the oldest
+ *    source job, once per instance of that source
+ *  - data age: sink job end minus the oldest sampling instant of the
+ *    data it used, for every sink job
+ *
+ * Nodes and edges live in fixed arrays, nothing is allocated after
+ * DagStart().
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __DAG_H__
+#define __DAG_H__
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "hist.h"
+#include "nstime.h"
+#include "release.h"
+#include "warmup.h"
+#include "workload.h"
+
+#define DAG_MAX_NODES 16
+#define DAG_MAX_EDGES 32
+#define DAG_MAX_IN 4			// Input edges per node
+#define DAG_NAME_LEN 24
+#define DAG_START_DELAY_NS (100*1000*1000)	// Time between the end of the warm-up and the first release
+
+// Job of a node: out = f(in[0..nin-1]). Returns 1 to send out to the output edges, 0 to send nothing
+typedef int (*dag_job)(const float *in, int nin, float *out, void *arg);
+
+struct dag_msg {
+	int src;			// Source node
+	uint64_t seq;		// Instance of src
+	nstime_t release;	// Release of the source job (absolute ns)
+	nstime_t stamp;		// Start of the source job, when the data was sampled (absolute ns)
+	float val;
+};
+
+struct dag_edge {
+	int from, to;
+	struct dag_msg msg;	// Last message, protected by the lock of the destination node
+	int fresh;			// msg not read yet
+	uint64_t lost;		// Messages overwritten before being read
+};
+
+struct dag;
+
+struct dag_node {
+	char name[DAG_NAME_LEN];
+	struct dag *g;
+	dag_job job;
+	void *arg;
+	struct workload load;	// Synthetic execution time of the job
+	int prio, cpu;			// SCHED_FIFO priority, core (-1: any)
+	nstime_t period, offset;	// Time-triggered if period > 0
+	int in[DAG_MAX_IN], nin;	// Input edges
+	int nout;				// Output edges
+	struct dag_msg held;	// Oldest input consumed since the last send
+	int nheld;				// Jobs merged in held
+	pthread_t thread;
+	pthread_mutex_t lock;	// Input edges and activation
+	pthread_cond_t cv;
+	struct release release;
+	struct warmup warm;
+	/* Statistics */
+	uint64_t jobs;
+	uint64_t last_seq[DAG_MAX_NODES];	// Sinks: last instance seen of each source
+	struct hist exec;		// Job execution time (ns)
+	struct hist latency;	// Sinks: end-to-end latency (ns)
+	struct hist age;		// Sinks: data age (ns)
+};
+
+struct dag {
+	struct dag_node node[DAG_MAX_NODES];
+	struct dag_edge edge[DAG_MAX_EDGES];
+	int nnodes, nedges;
+	struct release_cfg rel;		// Release mode of the time-triggered nodes
+	nstime_t start;				// Common time reference of the offsets
+	pthread_barrier_t barrier;	// Nodes warm (first wait), start set (second wait)
+};
+
+void DagInit(struct dag *g, const struct release_cfg *rel);
+int DagAddNode(struct dag *g, const char *name, dag_job job, void *arg, const struct workload_cfg *load,
+	int prio, int cpu, nstime_t period, nstime_t offset);
+int DagAddEdge(struct dag *g, int from, int to);
+int DagStart(struct dag *g);
+void DagPrint(const struct dag *g);
+
+#endif
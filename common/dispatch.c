@@ -0,0 +1,177 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Dispatcher: releases many logical periodic tasks from one thread
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dispatch.h"
+
+// Allocates a dispatcher for up to cap tasks. Returns 0 if Ok
+int DispInit(struct dispatcher *d, int cap, void (*job)(struct disp_task *t), const struct release_cfg *rel)
+{
+	memset(d, 0, sizeof(*d));
+	d->heap = calloc(cap, sizeof(struct disp_task *));
+	if(d->heap == NULL)
+		return -1;
+	d->cap = cap;
+	d->job = job;
+	ReleaseInit(&d->release, rel);
+	HistInit(&d->lat);
+	HistInit(&d->resp);
+	return 0;
+}
+
+static void DispSiftUp(struct dispatcher *d, int i)
+{
+	struct disp_task *t = d->heap[i];
+	int parent;
+
+	while(i > 0) {
+		parent = (i - 1) / 2;
+		if(d->heap[parent]->next <= t->next)
+			break;
+		d->heap[i] = d->heap[parent];
+		i = parent;
+	}
+	d->heap[i] = t;
+}
+
+static void DispSiftDown(struct dispatcher *d, int i)
+{
+	struct disp_task *t = d->heap[i];
+	int child;
+
+	while((child = 2 * i + 1) < d->n) {
+		if(child + 1 < d->n && d->heap[child + 1]->next < d->heap[child]->next)
+			child++;
+		if(t->next <= d->heap[child]->next)
+			break;
+		d->heap[i] = d->heap[child];
+		i = child;
+	}
+	d->heap[i] = t;
+}
+
+// Adds a task with its first release at first (absolute ns). Must be called before DispRun. Returns 0 if Ok
+int DispAdd(struct dispatcher *d, struct disp_task *t, nstime_t first)
+{
+	if(d->n == d->cap)
+		return -1;
+
+	t->next = first;
+	t->last = 0;
+	t->jobs = t->count = t->misses = 0;
+	t->iat_min = NSTIME_MAX;
+	t->iat_max = t->iat_sum = t->lat_max = 0;
+
+	d->heap[d->n] = t;
+	DispSiftUp(d, d->n++);
+	return 0;
+}
+
+// Runs every job of the task set once
+static void DispDry(void *arg)
+{
+	struct dispatcher *d = (struct dispatcher *) arg;
+	int i;
+
+	for(i = 0; i < d->n; i++)
+		d->job(d->heap[i]);
+}
+
+// Prefaults the calling (dispatcher) thread and runs every job once, dry
+void DispWarmup(struct dispatcher *d)
+{
+	WarmupThread(&d->warm);
+	WarmupWork(&d->warm, DispDry, d, 1);
+}
+
+// Makes the releases given to DispAdd relative to start (absolute ns). Must be called before DispRun
+void DispStart(struct dispatcher *d, nstime_t start)
+{
+	int i;
+
+	/* Same shift for every task, the heap order is kept */
+	for(i = 0; i < d->n; i++)
+		d->heap[i]->next = NsAdd(d->heap[i]->next, start);
+}
+
+// Dispatcher thread body. Never returns
+void DispRun(struct dispatcher *d)
+{
+	struct disp_task *t;
+	nstime_t ta, tf = 0, iat, lat, resp;
+
+	if(d->n == 0)
+		return;
+
+	while(1) {
+		/* Wait for the earliest release, unless it is already due */
+		t = d->heap[0];
+		if(t->next > tf)
+			ReleaseWait(&d->release, t->next);
+		ta = NsNow(CLOCK_MONOTONIC);
+
+		/* Do the actual processing */
+		d->job(t);
+
+		tf = NsNow(CLOCK_MONOTONIC);
+
+		/* Inter-arrival time, lateness and response time */
+		lat = NsSubSat(ta, t->next);
+		resp = NsSubSat(tf, t->next);
+		if(lat > t->lat_max)
+			t->lat_max = lat;
+		if(resp > t->deadline)
+			t->misses++;
+		HistRecord(&d->lat, lat);
+		HistRecord(&d->resp, resp);
+		d->jobs++;
+		if(++t->jobs > 1) {
+			iat = NsSubSat(ta, t->last);
+			if(iat < t->iat_min)
+				t->iat_min = iat;
+			if(iat > t->iat_max)
+				t->iat_max = iat;
+			t->iat_sum += iat;
+			t->count++;
+		}
+		t->last = ta;
+
+		/* Next release of the task, absolute */
+		t->next = NsAdd(t->next, t->period);
+		DispSiftDown(d, 0);
+	}
+}
+
+// Prints the statistics of the dispatcher (not used in the real-time path)
+void DispPrint(const struct dispatcher *d, const char *name)
+{
+	char label[80];
+
+	printf("%s: tasks: %d / jobs: %lu\n\r", name, d->n, d->jobs);
+	snprintf(label, sizeof(label), "  %s release lateness", name);
+	HistPrint(&d->lat, label);
+	snprintf(label, sizeof(label), "  %s response time", name);
+	HistPrint(&d->resp, label);
+	ReleasePrint(&d->release, name);
+	WarmupPrint(&d->warm, name);
+}
+
+// Prints the inter-arrival statistics of one task, in one line (values in ns)
+void DispTaskPrint(const struct disp_task *t, const char *name)
+{
+	if(t->count == 0) {
+		printf("  %s: no samples\n\r", name);
+		return;
+	}
+	printf("  %s: jobs: %lu / misses: %lu / inter-arrival min: %ld / mean: %ld / max: %ld / lateness max: %ld\n\r",
+		name, t->jobs, t->misses, t->iat_min, t->iat_sum / (nstime_t) t->count, t->iat_max, t->lat_max);
+}
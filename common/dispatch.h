@@ -0,0 +1,70 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Dispatcher: releases many logical periodic tasks from one thread
+ *
+ * The logical tasks of a dispatcher are kept in a min-heap ordered by
+ * their next absolute release. The dispatcher thread waits for the
+ * earliest release (release.h), runs that job to completion, advances
+ * the release of the task by its period (absolute arithmetic, no
+ * drift) and sifts it down. Jobs are not preempted by other jobs of the
+ * same dispatcher: a job released while another one runs starts late,
+ * and that lateness is measured.
+ *
+ * Per logical task only counters are kept (inter-arrival min/mean/max,
+ * worst lateness, deadline misses), so thousands of tasks fit in memory.
+ * Latency histograms are kept per dispatcher.
+ *
+ * DispWarmup() prefaults the dispatcher thread and runs every job once,
+ * dry (warmup.h). Releases can then be given relative to a start time
+ * that is only known after the warm-up, with DispStart(). Every job is
+ * recorded, the inter-arrival time from the second job of each task.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __DISPATCH_H__
+#define __DISPATCH_H__
+
+#include <stdint.h>
+
+#include "hist.h"
+#include "release.h"
+#include "nstime.h"
+#include "warmup.h"
+
+struct disp_task {
+	nstime_t period;		// ns
+	nstime_t deadline;		// ns, relative
+	nstime_t next;			// Next release (absolute ns, CLOCK_MONOTONIC)
+	nstime_t last;			// Last activation (absolute ns)
+	void *arg;				// Job argument
+	/* Statistics */
+	uint64_t jobs;			// Jobs run
+	uint64_t count;			// Inter-arrival times recorded
+	uint64_t misses;		// Response time above the deadline
+	nstime_t iat_min, iat_max, iat_sum;	// Inter-arrival time (ns)
+	nstime_t lat_max;		// Worst release lateness (ns)
+};
+
+struct dispatcher {
+	struct disp_task **heap;	// Min-heap on next
+	int n, cap;
+	void (*job)(struct disp_task *t);	// Job body
+	struct release release;		// Wait for the earliest release
+	struct hist lat;			// Release lateness of every job (ns)
+	struct hist resp;			// Response time of every job (ns)
+	uint64_t jobs;				// Jobs recorded
+	struct warmup warm;			// Warm-up of the dispatcher thread
+};
+
+int DispInit(struct dispatcher *d, int cap, void (*job)(struct disp_task *t), const struct release_cfg *rel);
+int DispAdd(struct dispatcher *d, struct disp_task *t, nstime_t first);
+void DispWarmup(struct dispatcher *d);
+void DispStart(struct dispatcher *d, nstime_t start);
+void DispRun(struct dispatcher *d);
+void DispPrint(const struct dispatcher *d, const char *name);
+void DispTaskPrint(const struct disp_task *t, const char *name);
+
+#endif
@@ -0,0 +1,207 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Streaming filters for sensor samples
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdint.h>
+
+#include "filter.h"
+
+// n / d rounded to the nearest, d > 0
+static int32_t DivRound(int64_t n, int32_t d)
+{
+	return (int32_t) (n >= 0 ? (n + d / 2) / d : (n - d / 2) / d);
+}
+
+// x / 2^bits rounded to the nearest
+static int32_t ShiftRound(int64_t x, int bits)
+{
+	return (int32_t) ((x + ((int64_t) 1 << (bits - 1))) >> bits);
+}
+
+/* ***********************************************
+* Moving average
+* ***********************************************/
+void FilterMaInit(struct filter_ma *f, int32_t *buf, uint32_t len)
+{
+	f->buf = buf;
+	f->len = len;
+	f->next = f->count = 0;
+	f->sum = 0;
+}
+
+int32_t FilterMa(struct filter_ma *f, int32_t x)
+{
+	if(f->count == f->len)
+		f->sum -= f->buf[f->next];
+	else
+		f->count++;
+	f->buf[f->next] = x;
+	f->sum += x;
+	if(++f->next == f->len)
+		f->next = 0;
+	return DivRound(f->sum, f->count);
+}
+
+/* ***********************************************
+* EMA
+* ***********************************************/
+void FilterEmaInit(struct filter_ema *f, int32_t alpha)
+{
+	f->alpha = alpha;
+	f->y = 0;
+	f->primed = 0;
+}
+
+int32_t FilterEma(struct filter_ema *f, int32_t x)
+{
+	int32_t xq = x * (1 << FILTER_EMA_FRAC);
+
+	if(!f->primed) {
+		f->y = xq;
+		f->primed = 1;
+	} else
+		f->y += ShiftRound((int64_t) (xq - f->y) * f->alpha, 15);
+	return ShiftRound(f->y, FILTER_EMA_FRAC);
+}
+
+/* ***********************************************
+* Biquad
+* ***********************************************/
+void FilterBiquadInit(struct filter_biquad *f, int32_t b0, int32_t b1, int32_t b2, int32_t a1, int32_t a2)
+{
+	f->b0 = b0;
+	f->b1 = b1;
+	f->b2 = b2;
+	f->a1 = a1;
+	f->a2 = a2;
+	f->x1 = f->x2 = f->y1 = f->y2 = 0;
+}
+
+int32_t FilterBiquad(struct filter_biquad *f, int32_t x)
+{
+	int64_t acc;
+	int32_t y;
+
+	acc = (int64_t) f->b0 * x + (int64_t) f->b1 * f->x1 + (int64_t) f->b2 * f->x2
+		- (int64_t) f->a1 * f->y1 - (int64_t) f->a2 * f->y2;
+	y = ShiftRound(acc, 14);
+	f->x2 = f->x1;
+	f->x1 = x;
+	f->y2 = f->y1;
+	f->y1 = y;
+	return y;
+}
+
+/* ***********************************************
+* Median
+* ***********************************************/
+#define HEAP(f, i) ((f)->s[(i) + (f)->len / 2].heap)	// Slot at heap index i
+#define VAL(f, i) ((f)->s[HEAP(f, i)].v)
+#define MIN_CT(f) (((f)->count - 1) / 2)				// Entries of the min-heap
+#define MAX_CT(f) ((f)->count / 2)						// Entries of the max-heap
+
+// Swaps heap entries i and j if the value at i is less. Returns 1 if swapped
+static int MedianSwapLess(struct filter_median *f, int i, int j)
+{
+	int16_t t;
+
+	if(VAL(f, i) >= VAL(f, j))
+		return 0;
+	t = HEAP(f, i);
+	HEAP(f, i) = HEAP(f, j);
+	HEAP(f, j) = t;
+	f->s[HEAP(f, i)].pos = i;
+	f->s[HEAP(f, j)].pos = j;
+	return 1;
+}
+
+// Min-heap from i / 2 down (i > 0)
+static void MedianMinDown(struct filter_median *f, int i)
+{
+	for(; i <= MIN_CT(f); i *= 2) {
+		if(i > 1 && i < MIN_CT(f) && VAL(f, i + 1) < VAL(f, i))
+			i++;
+		if(!MedianSwapLess(f, i, i / 2))
+			break;
+	}
+}
+
+// Max-heap from i / 2 down (i < 0)
+static void MedianMaxDown(struct filter_median *f, int i)
+{
+	for(; i >= -MAX_CT(f); i *= 2) {
+		if(i < -1 && i > -MAX_CT(f) && VAL(f, i) < VAL(f, i - 1))
+			i--;
+		if(!MedianSwapLess(f, i / 2, i))
+			break;
+	}
+}
+
+// Min-heap above i, up to the median. Returns 1 if the median changed
+static int MedianMinUp(struct filter_median *f, int i)
+{
+	while(i > 0 && MedianSwapLess(f, i, i / 2))
+		i /= 2;
+	return i == 0;
+}
+
+// Max-heap above i, up to the median. Returns 1 if the median changed
+static int MedianMaxUp(struct filter_median *f, int i)
+{
+	while(i < 0 && MedianSwapLess(f, i / 2, i))
+		i /= 2;
+	return i == 0;
+}
+
+void FilterMedianInit(struct filter_median *f, struct filter_median_slot *slots, int len)
+{
+	int k;
+
+	f->s = slots;
+	f->len = len;
+	f->next = f->count = 0;
+	// Slots fill the heap in the order median, max, min, max, min...
+	for(k = 0; k < len; k++) {
+		slots[k].v = 0;
+		slots[k].pos = ((k + 1) / 2) * ((k & 1) ? -1 : 1);
+		HEAP(f, slots[k].pos) = k;
+	}
+}
+
+int32_t FilterMedian(struct filter_median *f, int32_t x)
+{
+	int filling = f->count < f->len;
+	int p = f->s[f->next].pos;
+	int32_t old = f->s[f->next].v;
+
+	// x replaces the oldest sample, in its place in the heap
+	f->s[f->next].v = x;
+	if(++f->next == f->len)
+		f->next = 0;
+	f->count += filling;
+	if(p > 0) {
+		if(!filling && old < x)
+			MedianMinDown(f, p * 2);
+		else if(MedianMinUp(f, p))
+			MedianMaxDown(f, -1);
+	} else if(p < 0) {
+		if(!filling && x < old)
+			MedianMaxDown(f, p * 2);
+		else if(MedianMaxUp(f, p))
+			MedianMinDown(f, 1);
+	} else {
+		if(MAX_CT(f))
+			MedianMaxDown(f, -1);
+		if(MIN_CT(f))
+			MedianMinDown(f, 1);
+	}
+
+	if((f->count & 1) == 0)
+		return DivRound((int64_t) VAL(f, 0) + VAL(f, -1), 2);
+	return VAL(f, 0);
+}
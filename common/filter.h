@@ -0,0 +1,89 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Streaming filters for sensor samples
+ *
+ * One sample in, one value out, in fixed memory and bounded time:
+ *  - moving average: mean of the last len samples, running sum over
+ *    a circular buffer, O(1)
+ *  - EMA: y += alpha * (x - y), alpha in Q15, O(1)
+ *  - biquad: second order IIR (direct form I), coefficients in Q14,
+ *    O(1). FILTER_Q14() converts a constant at compile time
+ *  - median: median of the last len samples, with the two heaps
+ *    (max-heap below, min-heap above the median) kept in one array
+ *    indexed by the circular buffer, O(log len)
+ * While the window fills, the average and the median are of the
+ * samples seen so far.
+ *
+ * Integer only (int32_t samples, 64-bit products), so it costs the
+ * same on the PIC32 (no FPU, lab3) as on the host, where the results
+ * are bit-for-bit the ones of the board. The buffers are given by the
+ * caller, their size sets the window at compile time, nothing is
+ * allocated (as lockfree.h). lab1/filtcheck checks them against brute
+ * force and double precision references.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __FILTER_H__
+#define __FILTER_H__
+
+#include <stdint.h>
+
+#define FILTER_Q15(x) ((int32_t) ((x) * 32768.0 + ((x) >= 0 ? 0.5 : -0.5)))
+#define FILTER_Q14(x) ((int32_t) ((x) * 16384.0 + ((x) >= 0 ? 0.5 : -0.5)))
+#define FILTER_EMA_FRAC 8		// Extra fraction bits of the EMA state
+
+/* Moving average. |sample| * len must fit in 31 bits */
+struct filter_ma {
+	int32_t *buf;			// len samples
+	uint32_t len;
+	uint32_t next;			// Slot of the next sample
+	uint32_t count;			// Samples in the window (<= len)
+	int32_t sum;
+};
+
+/* Exponential moving average */
+struct filter_ema {
+	int32_t alpha;			// Q15, 0 < alpha <= 1
+	int32_t y;				// Q(FILTER_EMA_FRAC)
+	int primed;				// 0 until the first sample
+};
+
+/* Biquad: y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2, a0 = 1 */
+struct filter_biquad {
+	int32_t b0, b1, b2, a1, a2;	// Q14
+	int32_t x1, x2, y1, y2;
+};
+
+/* Median. Slot k holds a sample of the circular buffer (v, and pos:
+ * its place in the heap) and the heap entry k - len/2 (heap: a slot).
+ * Heap index 0 is the median, 1..(count-1)/2 the min-heap and
+ * -1..-count/2 the max-heap */
+struct filter_median_slot {
+	int32_t v;
+	int16_t pos;
+	int16_t heap;
+};
+
+struct filter_median {
+	struct filter_median_slot *s;	// len slots
+	int len;
+	int next;
+	int count;
+};
+
+void FilterMaInit(struct filter_ma *f, int32_t *buf, uint32_t len);
+int32_t FilterMa(struct filter_ma *f, int32_t x);
+
+void FilterEmaInit(struct filter_ema *f, int32_t alpha);
+int32_t FilterEma(struct filter_ema *f, int32_t x);
+
+void FilterBiquadInit(struct filter_biquad *f, int32_t b0, int32_t b1, int32_t b2, int32_t a1, int32_t a2);
+int32_t FilterBiquad(struct filter_biquad *f, int32_t x);
+
+void FilterMedianInit(struct filter_median *f, struct filter_median_slot *slots, int len);
+int32_t FilterMedian(struct filter_median *f, int32_t x);
+
+#endif
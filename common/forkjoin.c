@@ -0,0 +1,189 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Fork-join jobs: one periodic job split over several cores
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "forkjoin.h"
+#include "workload.h"
+#include "kernels.h"
+
+static inline void FjRelax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+// Waits until the n threads of the barrier arrive
+static void FjWait(struct fj_barrier *b)
+{
+	int gen = __atomic_load_n(&b->gen, __ATOMIC_ACQUIRE), i;
+
+	/* Last one: rearm and release the others */
+	if(__atomic_sub_fetch(&b->count, 1, __ATOMIC_ACQ_REL) == 0) {
+		__atomic_store_n(&b->count, b->n, __ATOMIC_RELAXED);
+		__atomic_store_n(&b->gen, gen + 1, __ATOMIC_SEQ_CST);
+		if(__atomic_load_n(&b->sleepers, __ATOMIC_SEQ_CST))
+			syscall(SYS_futex, &b->gen, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+		return;
+	}
+
+	for(i = 0; i < FJ_SPIN; i++) {
+		if(__atomic_load_n(&b->gen, __ATOMIC_ACQUIRE) != gen)
+			return;
+		FjRelax();
+	}
+
+	/* The releaser checks sleepers after changing gen, so either it wakes us or the futex sees the new gen */
+	__atomic_add_fetch(&b->sleepers, 1, __ATOMIC_SEQ_CST);
+	while(__atomic_load_n(&b->gen, __ATOMIC_SEQ_CST) == gen)
+		syscall(SYS_futex, &b->gen, FUTEX_WAIT_PRIVATE, gen, NULL, NULL, 0);
+	__atomic_sub_fetch(&b->sleepers, 1, __ATOMIC_RELAXED);
+}
+
+// Integrates slice id of the current job
+static void FjSlice(struct fj_pool *p, int id)
+{
+	long from = p->iters * id / p->n, to = p->iters * (id + 1) / p->n;
+	float step = (KERN_UPPER - KERN_LOWER) / p->iters;
+	nstime_t t0 = NsNow(CLOCK_MONOTONIC);
+
+	p->part[id] = WorkloadSpan(KERN_LOWER + from * step, KERN_LOWER + to * step, to - from);
+	p->w[id].busy = NsSubSat(NsNow(CLOCK_MONOTONIC), t0);
+}
+
+static void *FjWorker(void *arg)
+{
+	struct fj_worker *w = (struct fj_worker *) arg;
+
+	while(1) {
+		FjWait(&w->pool->bar);	// Fork
+		if(__atomic_load_n(&w->pool->quit, __ATOMIC_ACQUIRE))
+			break;
+		FjSlice(w->pool, w->id);
+		FjWait(&w->pool->bar);	// Join
+	}
+	return NULL;
+}
+
+// Stops and joins the workers 1..created-1 after a failed FjInit. They wait at the fork barrier for n threads:
+// the missing ones are taken out of the barrier and the caller releases the others
+static void FjAbort(struct fj_pool *p, int created)
+{
+	int i;
+
+	__atomic_store_n(&p->quit, 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&p->bar.n, created, __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&p->bar.count, p->n - created, __ATOMIC_ACQ_REL);
+	FjWait(&p->bar);
+	for(i = 1; i < created; i++)
+		pthread_join(p->w[i].thread, NULL);
+}
+
+// Spawns n-1 workers for the calling thread. Thread k runs on the k-th core of cpus (cycling), the caller on the first.
+// Returns 0 if Ok. On error no worker is left running and the caller keeps its affinity
+int FjInit(struct fj_pool *p, int n, const cpu_set_t *cpus, int policy, int prio)
+{
+	struct sched_param parm;
+	pthread_attr_t attr;
+	cpu_set_t one;
+	int cores[CPU_SETSIZE], ncores = 0, online = sysconf(_SC_NPROCESSORS_ONLN), i, err;
+
+	memset(p, 0, sizeof(*p));
+	if(n < 1 || n > FJ_MAX)
+		return -1;
+	for(i = 0; i < online && ncores < n; i++)
+		if(CPU_ISSET(i, cpus))
+			cores[ncores++] = i;
+	if(ncores == 0)
+		return -1;
+
+	p->n = n;
+	p->bar.n = p->bar.count = n;
+	HistInit(&p->makespan);
+	HistInit(&p->overhead);
+
+	p->w[0].pool = p;
+	p->w[0].thread = pthread_self();
+
+	for(i = 1; i < n; i++) {
+		p->w[i].pool = p;
+		p->w[i].id = i;
+		CPU_ZERO(&one);
+		CPU_SET(cores[i % ncores], &one);
+		parm.sched_priority = prio;
+		pthread_attr_init(&attr);
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, policy);
+		pthread_attr_setschedparam(&attr, &parm);
+		pthread_attr_setaffinity_np(&attr, sizeof(one), &one);
+		err = pthread_create(&p->w[i].thread, &attr, FjWorker, &p->w[i]);
+		pthread_attr_destroy(&attr);
+		if(err != 0) {
+			printf("Error creating fork-join worker %d [%s]\n\r", i, strerror(err));
+			FjAbort(p, i);
+			return -1;
+		}
+	}
+
+	/* Pinned only once every worker runs */
+	CPU_ZERO(&one);
+	CPU_SET(cores[0], &one);
+	pthread_setaffinity_np(pthread_self(), sizeof(one), &one);
+	return 0;
+}
+
+// Runs one job of exec ns of load (single core time) split over the pool. Called by the job thread.
+// Returns the integration value
+float FjJob(struct fj_pool *p, nstime_t exec)
+{
+	nstime_t t0, span, busy = 0;
+	float sum = 0;
+	int i;
+
+	t0 = NsNow(CLOCK_MONOTONIC);
+	p->iters = WorkloadIters(exec);
+	FjWait(&p->bar);	// Fork
+	FjSlice(p, 0);
+	FjWait(&p->bar);	// Join
+	span = NsSubSat(NsNow(CLOCK_MONOTONIC), t0);
+
+	for(i = 0; i < p->n; i++) {
+		sum += p->part[i];
+		if(p->w[i].busy > busy)
+			busy = p->w[i].busy;
+	}
+	HistRecord(&p->makespan, span);
+	HistRecord(&p->overhead, NsSubSat(span, busy));
+	return sum;
+}
+
+// Clears the statistics (e.g. after warm-up)
+void FjReset(struct fj_pool *p)
+{
+	HistInit(&p->makespan);
+	HistInit(&p->overhead);
+}
+
+// Prints the makespan and barrier overhead of the jobs (not used in the real-time path)
+void FjPrint(const struct fj_pool *p, const char *name)
+{
+	char label[80];
+
+	snprintf(label, sizeof(label), "  %s makespan (%d threads)", name, p->n);
+	HistPrint(&p->makespan, label);
+	snprintf(label, sizeof(label), "  %s barrier overhead", name);
+	HistPrint(&p->overhead, label);
+}
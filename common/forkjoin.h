@@ -0,0 +1,68 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Fork-join jobs: one periodic job split over several cores
+ *
+ * A pool is the job thread plus n-1 worker threads, spawned once by
+ * FjInit() and pinned one per core of a CPU set, with the policy and
+ * priority of the task. For each job, FjJob() publishes the number of
+ * sub-intervals of the load (see workload.h), releases the workers
+ * through a barrier, integrates its own slice and waits for the others
+ * at a second barrier. Nothing is allocated per job.
+ *
+ * The barrier spins for FJ_SPIN polls and then sleeps on a futex, so
+ * short gaps between the slices cost no system call and idle workers
+ * do not burn their core between jobs.
+ *
+ * Per job: makespan (job start to the last slice joined) and barrier
+ * overhead (makespan minus the longest slice).
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __FORKJOIN_H__
+#define __FORKJOIN_H__
+
+#include <sched.h> // cpu_set_t, requires _GNU_SOURCE
+#include <pthread.h>
+
+#include "hist.h"
+#include "nstime.h"
+
+#define FJ_MAX 16			// Threads per pool, job thread included
+#define FJ_SPIN 20000		// Barrier polls before sleeping on the futex
+
+struct fj_barrier {
+	int n;				// Threads
+	int count;			// Threads still to arrive
+	int gen;			// Generation, also the futex word
+	int sleepers;		// Threads sleeping on the futex
+};
+
+struct fj_pool;
+
+struct fj_worker {
+	struct fj_pool *pool;
+	int id;				// Slice, 0 is the job thread
+	pthread_t thread;
+	nstime_t busy;		// Time spent on the slice of the current job (ns)
+};
+
+struct fj_pool {
+	int n;					// Threads
+	struct fj_barrier bar;
+	struct fj_worker w[FJ_MAX];
+	long iters;				// Sub-intervals of the current job
+	int quit;				// Workers exit at the next fork (FjInit failed)
+	float part[FJ_MAX];		// Partial integrals
+	struct hist makespan;	// Job start to join (ns)
+	struct hist overhead;	// Makespan minus the longest slice (ns)
+};
+
+int FjInit(struct fj_pool *p, int n, const cpu_set_t *cpus, int policy, int prio);
+float FjJob(struct fj_pool *p, nstime_t exec);
+void FjReset(struct fj_pool *p);
+void FjPrint(const struct fj_pool *p, const char *name);
+
+#endif
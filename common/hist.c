@@ -0,0 +1,78 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Log-linear (HDR-style) histogram for latency measurements
+ * Percentile extraction and reporting (not used in the real-time path)
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "hist.h"
+
+// Clears the histogram
+void HistInit(struct hist *h)
+{
+	memset(h, 0, sizeof(*h));
+	h->min = UINT64_MAX;
+}
+
+// Highest value that falls in bucket i
+static uint64_t HistBucketTop(unsigned int i)
+{
+	unsigned int shift;
+	uint64_t low;
+
+	if(i < HIST_SUB_COUNT)
+		return i;
+	shift = i / HIST_SUB_COUNT - 1;
+	low = (uint64_t) (HIST_SUB_COUNT + i % HIST_SUB_COUNT) << shift;
+	return low + ((uint64_t) 1 << shift) - 1;
+}
+
+// Value below which p percent (0..100) of the recorded values lie
+uint64_t HistPercentile(const struct hist *h, double p)
+{
+	uint64_t target, acc = 0, v;
+	unsigned int i;
+
+	if(h->count == 0)
+		return 0;
+
+	target = (uint64_t) ceil(p / 100.0 * h->count);
+	if(target < 1)
+		target = 1;
+
+	for(i = 0; i < HIST_BUCKETS; i++) {
+		acc += h->bins[i];
+		if(acc >= target) {
+			v = HistBucketTop(i);
+			return v > h->max ? h->max : v;
+		}
+	}
+	return h->max; // Percentile falls in the overflow values
+}
+
+// Mean of the recorded values
+uint64_t HistMean(const struct hist *h)
+{
+	return h->count ? h->sum / h->count : 0;
+}
+
+// Prints the tail summary of the histogram (values in ns)
+void HistPrint(const struct hist *h, const char *name)
+{
+	if(h->count == 0) {
+		printf("%s: no samples\n\r", name);
+		return;
+	}
+
+	printf("%s: n: %lu min: %lu / mean: %lu / p50: %lu / p90: %lu / p99: %lu / p99.9: %lu / p99.99: %lu / max: %lu\n\r",
+		name, h->count, h->min, HistMean(h),
+		HistPercentile(h, 50.0), HistPercentile(h, 90.0), HistPercentile(h, 99.0),
+		HistPercentile(h, 99.9), HistPercentile(h, 99.99), h->max);
+}
@@ -0,0 +1,69 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Log-linear (HDR-style) histogram for latency measurements
+ *
+ * Values (in ns) are grouped by power of two and each group is split
+ * in HIST_SUB_COUNT linear sub-buckets, so the relative error of any
+ * reported value is below 1/HIST_SUB_COUNT (~0.1%).
+ * The histogram is a plain struct with no dynamic memory, and
+ * HistRecord() is inlined: one clz, one shift and one increment.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __HIST_H__
+#define __HIST_H__
+
+#include <stdint.h>
+
+#ifndef HIST_SUB_BITS
+#define HIST_SUB_BITS 10				// log2 of sub-buckets per power of two
+#endif
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 36				// Largest value tracked is 2^36 ns (~68 s)
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB_COUNT)
+
+struct hist {
+	uint64_t count;		// Number of recorded values
+	uint64_t min, max;	// Exact extreme values
+	uint64_t sum;		// Sum of the recorded values (mean)
+	uint64_t overflow;	// Values above 2^HIST_MAX_BITS (counted as max)
+	uint32_t bins[HIST_BUCKETS];
+};
+
+void HistInit(struct hist *h);
+uint64_t HistPercentile(const struct hist *h, double p);
+uint64_t HistMean(const struct hist *h);
+void HistPrint(const struct hist *h, const char *name);
+
+/* Bucket index of value v. Group 0 is linear, group g > 0 covers [2^(g+SUB_BITS-1), 2^(g+SUB_BITS)) */
+static inline unsigned int HistIndex(uint64_t v)
+{
+	unsigned int shift;
+
+	if(v < HIST_SUB_COUNT)
+		return (unsigned int) v;
+	shift = (63 - __builtin_clzll(v)) - HIST_SUB_BITS;
+	return (shift + 1) * HIST_SUB_COUNT + (unsigned int) ((v >> shift) - HIST_SUB_COUNT);
+}
+
+/* Record one value. Safe to call from the real-time path (no locks, no syscalls) */
+static inline void HistRecord(struct hist *h, uint64_t v)
+{
+	if(v < h->min)
+		h->min = v;
+	if(v > h->max)
+		h->max = v;
+	h->count++;
+	h->sum += v;
+
+	if(v >> HIST_MAX_BITS) {
+		h->overflow++;
+		return;
+	}
+	h->bins[HistIndex(v)]++;
+}
+
+#endif
@@ -0,0 +1,298 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Integration kernels: scalar and SIMD versions of the Heavy_Work load
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERN_X86
+#endif
+
+#include "kernels.h"
+
+// Task load. In the case integrates numerically a function
+#define f(x) 1/(1+pow(x,2)) /* Define function to integrate*/
+static float KernScalar(float lower, float upper, long subInterval)
+{
+	float integration=0.0, stepSize, k;
+	long i;
+
+	if(subInterval < 2)
+		return 0;
+
+	/* Finding step size */
+	stepSize = (upper - lower)/subInterval;
+
+	/* Finding Integration Value */
+	integration = f(lower) + f(upper);
+	for(i=1; i<= subInterval-1; i++)
+	{
+		k = lower + i*stepSize;
+		integration = integration + 2 * f(k);
+	}
+	return integration * stepSize/2;
+}
+
+// Scalar tail of the vector kernels: sum of f(lower + i*step) for i in [from, to)
+static float KernTail(float lower, float step, long from, long to)
+{
+	float sum = 0, x;
+	long i;
+
+	for(i = from; i < to; i++) {
+		x = lower + i * step;
+		sum += 1 / (1 + x * x);
+	}
+	return sum;
+}
+
+// The vector kernels one point at a time: x*x, not pow, and the same sums
+static float KernMul(float lower, float upper, long n)
+{
+	float step, ends;
+
+	if(n < 2)
+		return 0;
+	step = (upper - lower) / n;
+	ends = 1 / (1 + lower * lower) + 1 / (1 + upper * upper);
+	return (ends + 2 * KernTail(lower, step, 1, n)) * step / 2;
+}
+
+#ifdef KERN_X86
+
+__attribute__((target("sse2")))
+static float KernSse(float lower, float upper, long n)
+{
+	float step, ends, sum;
+	__m128 vstep, vlow, vone, vidx, vinc, acc, x;
+	long i;
+
+	if(n < 2)
+		return 0;
+	step = (upper - lower) / n;
+	ends = 1 / (1 + lower * lower) + 1 / (1 + upper * upper);
+
+	vstep = _mm_set1_ps(step);
+	vlow = _mm_set1_ps(lower);
+	vone = _mm_set1_ps(1);
+	vinc = _mm_set1_ps(4);
+	vidx = _mm_setr_ps(1, 2, 3, 4);
+	acc = _mm_setzero_ps();
+	for(i = 1; i + 4 <= n; i += 4) {
+		x = _mm_add_ps(vlow, _mm_mul_ps(vidx, vstep));
+		acc = _mm_add_ps(acc, _mm_div_ps(vone, _mm_add_ps(vone, _mm_mul_ps(x, x))));
+		vidx = _mm_add_ps(vidx, vinc);
+	}
+
+	/* Horizontal sum */
+	acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+	acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+	sum = _mm_cvtss_f32(acc) + KernTail(lower, step, i, n);
+	return (ends + 2 * sum) * step / 2;
+}
+
+__attribute__((target("avx2,fma")))
+static float KernAvx2(float lower, float upper, long n)
+{
+	float step, ends, sum;
+	__m256 vstep, vlow, vone, vidx, vinc, acc, x;
+	__m128 h;
+	long i;
+
+	if(n < 2)
+		return 0;
+	step = (upper - lower) / n;
+	ends = 1 / (1 + lower * lower) + 1 / (1 + upper * upper);
+
+	vstep = _mm256_set1_ps(step);
+	vlow = _mm256_set1_ps(lower);
+	vone = _mm256_set1_ps(1);
+	vinc = _mm256_set1_ps(8);
+	vidx = _mm256_setr_ps(1, 2, 3, 4, 5, 6, 7, 8);
+	acc = _mm256_setzero_ps();
+	for(i = 1; i + 8 <= n; i += 8) {
+		x = _mm256_fmadd_ps(vidx, vstep, vlow);
+		acc = _mm256_add_ps(acc, _mm256_div_ps(vone, _mm256_fmadd_ps(x, x, vone)));
+		vidx = _mm256_add_ps(vidx, vinc);
+	}
+
+	/* Horizontal sum */
+	h = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+	h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+	h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+	sum = _mm_cvtss_f32(h);
+
+	/* Clean upper state, or the SSE code that follows (libm) pays a transition penalty. Not inserted by gcc at -O0 */
+	_mm256_zeroupper();
+	sum += KernTail(lower, step, i, n);
+	return (ends + 2 * sum) * step / 2;
+}
+
+__attribute__((target("avx512f")))
+static float KernAvx512(float lower, float upper, long n)
+{
+	float step, ends, sum;
+	__m512 vstep, vlow, vone, vidx, vinc, acc, x;
+	long i;
+
+	if(n < 2)
+		return 0;
+	step = (upper - lower) / n;
+	ends = 1 / (1 + lower * lower) + 1 / (1 + upper * upper);
+
+	vstep = _mm512_set1_ps(step);
+	vlow = _mm512_set1_ps(lower);
+	vone = _mm512_set1_ps(1);
+	vinc = _mm512_set1_ps(16);
+	vidx = _mm512_setr_ps(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+	acc = _mm512_setzero_ps();
+	for(i = 1; i + 16 <= n; i += 16) {
+		x = _mm512_fmadd_ps(vidx, vstep, vlow);
+		acc = _mm512_add_ps(acc, _mm512_div_ps(vone, _mm512_fmadd_ps(x, x, vone)));
+		vidx = _mm512_add_ps(vidx, vinc);
+	}
+
+	sum = _mm512_reduce_add_ps(acc);
+	_mm256_zeroupper(); // See KernAvx2
+	sum += KernTail(lower, step, i, n);
+	return (ends + 2 * sum) * step / 2;
+}
+
+#endif
+
+static const struct {
+	const char *name;
+	int lanes;
+	kern_fn fn;
+} kernels[KERN_COUNT] = {
+	{ "scalar", 1, KernScalar },
+	{ "mul", 1, KernMul },
+#ifdef KERN_X86
+	{ "sse", 4, KernSse },
+	{ "avx2", 8, KernAvx2 },
+	{ "avx512", 16, KernAvx512 },
+#else
+	{ "sse", 4, NULL },
+	{ "avx2", 8, NULL },
+	{ "avx512", 16, NULL },
+#endif
+};
+
+// Returns 1 if kernel k runs on this CPU
+int KernSupported(int k)
+{
+	if(k < 0 || k >= KERN_COUNT || kernels[k].fn == NULL)
+		return 0;
+#ifdef KERN_X86
+	__builtin_cpu_init();
+	switch(k) {
+	case KERN_SSE:
+		return __builtin_cpu_supports("sse2");
+	case KERN_AVX2:
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	case KERN_AVX512:
+		return __builtin_cpu_supports("avx512f");
+	}
+#endif
+	return 1;
+}
+
+// Widest kernel supported by this CPU
+int KernBest(void)
+{
+	int k;
+
+	for(k = KERN_COUNT - 1; k > KERN_SCALAR && !KernSupported(k); k--);
+	return k;
+}
+
+// Kernel function, or NULL if not supported by this CPU
+kern_fn KernGet(int k)
+{
+	return KernSupported(k) ? kernels[k].fn : NULL;
+}
+
+const char *KernName(int k)
+{
+	return k >= 0 && k < KERN_COUNT ? kernels[k].name : "?";
+}
+
+int KernLanes(int k)
+{
+	return k >= 0 && k < KERN_COUNT ? kernels[k].lanes : 0;
+}
+
+// Kernel of a name, "best" for the widest one. Returns -1 if unknown
+int KernParse(const char *str)
+{
+	int k;
+
+	if(!strcmp(str, "best"))
+		return KernBest();
+	for(k = 0; k < KERN_COUNT; k++)
+		if(!strcmp(str, kernels[k].name))
+			return k;
+	return -1;
+}
+
+// Trapezoid rule in double precision: the reference of the vector kernels
+static double KernDouble(double lower, double upper, long n)
+{
+	double step, sum = 0, x;
+	long i;
+
+	step = (upper - lower) / n;
+	for(i = 1; i < n; i++) {
+		x = lower + i * step;
+		sum += 1 / (1 + x * x);
+	}
+	return (1 / (1 + lower * lower) + 1 / (1 + upper * upper) + 2 * sum) * step / 2;
+}
+
+// Runs every supported kernel over n sub-intervals: the vector ones against the double precision sum (KERN_TOL),
+// mul against scalar (KERN_MUL_TOL, same float accumulator), at most KERN_VERIFY_MAX. Returns the number of kernels
+// off by more
+int KernVerify(long n)
+{
+	double exact = atan(KERN_UPPER) - atan(KERN_LOWER), ref, diff, tol;
+	float scalar, v;
+	int k, bad = 0;
+
+	if(n > KERN_VERIFY_MAX)
+		n = KERN_VERIFY_MAX;
+	ref = KernDouble(KERN_LOWER, KERN_UPPER, n);
+	scalar = KernScalar(KERN_LOWER, KERN_UPPER, n);
+
+	printf("Kernel verification, %ld sub-intervals (exact %.6f, double %.6f)\n\r", n, exact, ref);
+	for(k = 0; k < KERN_COUNT; k++) {
+		if(!KernSupported(k)) {
+			printf("  %-8s not supported by this CPU\n\r", kernels[k].name);
+			continue;
+		}
+		v = kernels[k].fn(KERN_LOWER, KERN_UPPER, n);
+		if(k == KERN_SCALAR) {
+			printf("  %-8s %.6f / vs double: %.2e / reference of mul\n\r", kernels[k].name, v, fabs(v - ref) / ref);
+			continue;
+		}
+		if(k == KERN_MUL) {
+			diff = fabs(v - scalar) / fabs(scalar);
+			tol = KERN_MUL_TOL;
+			printf("  %-8s %.6f / vs scalar: %.2e", kernels[k].name, v, diff);
+		} else {
+			diff = fabs(v - ref) / ref;
+			tol = KERN_TOL;
+			printf("  %-8s %.6f / vs double: %.2e", kernels[k].name, v, diff);
+		}
+		printf(" %s\n\r", diff > tol ? "MISMATCH" : "ok");
+		bad += diff > tol;
+	}
+	return bad;
+}
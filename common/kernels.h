@@ -0,0 +1,53 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Integration kernels: scalar and SIMD versions of the Heavy_Work load
+ *
+ * Trapezoid rule of f(x) = 1/(1+x*x) over [lower, upper] with n
+ * sub-intervals. KERN_SCALAR is the original Heavy_Work loop (pow and
+ * one float accumulator) and is the reference. KERN_MUL is the same
+ * sum with x*x instead of pow, one point at a time: the baseline of
+ * the vector versions, which compute 4 (SSE), 8 (AVX2 + FMA) or 16
+ * (AVX-512F) points per step, each built with its own target
+ * attribute, so one binary runs on any x86 host: KernSupported()
+ * checks the CPU at runtime and KernBest() picks the widest one
+ * available. Other architectures only have the scalar kernels.
+ *
+ * The scalar float accumulator drifts with n (~0.6% at 1e6 points), so
+ * KernVerify() checks the vector kernels, which keep one accumulator
+ * per lane, against the same sum in double precision (KERN_TOL), and
+ * mul, which drifts as scalar, against scalar (KERN_MUL_TOL). The lanes
+ * drift too above ~1e6 points (~1% at 1e7), so larger n are verified
+ * at KERN_VERIFY_MAX.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __KERNELS_H__
+#define __KERNELS_H__
+
+#define KERN_SCALAR 0
+#define KERN_MUL 1
+#define KERN_SSE 2
+#define KERN_AVX2 3
+#define KERN_AVX512 4
+#define KERN_COUNT 5
+
+#define KERN_LOWER 0.0f		// Integration interval of Heavy_Work
+#define KERN_UPPER 100.0f
+#define KERN_TOL 1e-3		// Relative difference of the vector kernels accepted against double precision
+#define KERN_MUL_TOL 1e-5	// Relative difference of mul accepted against scalar
+#define KERN_VERIFY_MAX 1000000	// Largest number of sub-intervals verified
+
+typedef float (*kern_fn)(float lower, float upper, long n);
+
+int KernSupported(int k);
+int KernBest(void);
+kern_fn KernGet(int k);
+const char *KernName(int k);
+int KernLanes(int k);
+int KernParse(const char *str);
+int KernVerify(long n);
+
+#endif
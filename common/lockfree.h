@@ -0,0 +1,186 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Lock-free shared state between real-time tasks
+ *
+ * Wait-free primitives (no locks, no system calls, bounded steps) to
+ * share data between tasks without semaphores, so a task never blocks
+ * on a lower priority one (no priority inversion):
+ *  - counter: atomic sequence number, any number of tasks
+ *  - seqlock: multi-word state, one writer and any number of readers.
+ *    The writer never waits, a reader retries if a write overlapped
+ *    its copy (bounded if the writer period is longer than the copy)
+ *  - triple buffer: latest value handoff, one writer and one reader.
+ *    Both always get a buffer of their own, the reader gets the last
+ *    complete value and older ones are overwritten
+ *  - ring: single-producer/single-consumer FIFO of fixed size elements
+ *    (power of 2 slots). Push fails if full, pop fails if empty
+ *
+ * Header only, with 32-bit indexes and the GCC __atomic builtins, so
+ * the same file builds for POSIX (lab1/lab2) and for FreeRTOS on the
+ * PIC32 (XC32, lab3), where 32-bit atomics are native (ll/sc). The data
+ * buffers are given by the caller, nothing is allocated.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __LOCKFREE_H__
+#define __LOCKFREE_H__
+
+#include <stdint.h>
+#include <string.h>
+
+/* ***********************************************
+* Sequence counter
+* ***********************************************/
+struct lf_counter {
+	uint32_t v;
+};
+
+static inline void LfCounterSet(struct lf_counter *c, uint32_t v)
+{
+	__atomic_store_n(&c->v, v, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t LfCounterGet(struct lf_counter *c)
+{
+	return __atomic_load_n(&c->v, __ATOMIC_ACQUIRE);
+}
+
+/* Increments the counter. Returns the new value */
+static inline uint32_t LfCounterNext(struct lf_counter *c)
+{
+	return __atomic_add_fetch(&c->v, 1, __ATOMIC_ACQ_REL);
+}
+
+
+/* ***********************************************
+* Seqlock: odd sequence while a write is in progress
+* ***********************************************/
+struct lf_seqlock {
+	uint32_t seq;
+};
+
+/* Copies size bytes of src to the shared state dst. One writer only */
+static inline void LfSeqWrite(struct lf_seqlock *s, void *dst, const void *src, size_t size)
+{
+	uint32_t seq = __atomic_load_n(&s->seq, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&s->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(dst, src, size);
+	__atomic_store_n(&s->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/* Copies size bytes of the shared state src to dst, retrying until no write overlaps. Returns the retries */
+static inline uint32_t LfSeqRead(struct lf_seqlock *s, void *dst, const void *src, size_t size)
+{
+	uint32_t seq, retries = 0;
+
+	while(1) {
+		seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+		if(!(seq & 1)) {
+			memcpy(dst, src, size);
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if(__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == seq)
+				return retries;
+		}
+		retries++;
+	}
+}
+
+
+/* ***********************************************
+* Triple buffer: indexes 0..2 of a buffer array of the caller
+* ***********************************************/
+#define LF_TRIPLE_NEW 4		// Middle buffer has a value not read yet
+
+struct lf_triple {
+	uint32_t middle;		// Shared: middle buffer index | LF_TRIPLE_NEW
+	uint32_t back;			// Writer only: buffer being written
+	uint32_t front;			// Reader only: buffer being read
+};
+
+static inline void LfTripleInit(struct lf_triple *t)
+{
+	t->back = 0;
+	t->middle = 1;
+	t->front = 2;
+}
+
+/* Buffer the writer fills next */
+static inline uint32_t LfTripleBack(const struct lf_triple *t)
+{
+	return t->back;
+}
+
+/* Publishes the back buffer and takes the middle one as the new back buffer */
+static inline void LfTriplePublish(struct lf_triple *t)
+{
+	t->back = __atomic_exchange_n(&t->middle, t->back | LF_TRIPLE_NEW, __ATOMIC_ACQ_REL) & 3;
+}
+
+/* Buffer with the last published value. fresh (may be NULL) tells if it was not read before */
+static inline uint32_t LfTripleRead(struct lf_triple *t, int *fresh)
+{
+	int isnew = (__atomic_load_n(&t->middle, __ATOMIC_RELAXED) & LF_TRIPLE_NEW) != 0;
+
+	if(isnew)
+		t->front = __atomic_exchange_n(&t->middle, t->front, __ATOMIC_ACQ_REL) & 3;
+	if(fresh != NULL)
+		*fresh = isnew;
+	return t->front;
+}
+
+
+/* ***********************************************
+* SPSC ring
+* ***********************************************/
+struct lf_ring {
+	uint32_t head;			// Next slot to write (producer only)
+	uint32_t tail;			// Next slot to read (consumer only)
+	uint32_t size;			// Slots, power of 2
+	uint32_t esize;			// Bytes per element
+	uint8_t *buf;			// size * esize bytes
+};
+
+static inline void LfRingInit(struct lf_ring *r, void *buf, uint32_t size, uint32_t esize)
+{
+	r->head = r->tail = 0;
+	r->size = size;
+	r->esize = esize;
+	r->buf = (uint8_t *) buf;
+}
+
+/* Producer. Returns 0 if Ok, -1 if the ring is full */
+static inline int LfRingPush(struct lf_ring *r, const void *e)
+{
+	uint32_t head = r->head;
+
+	if(head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= r->size)
+		return -1;
+	memcpy(r->buf + (head & (r->size - 1)) * r->esize, e, r->esize);
+	__atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/* Producer. Free slots, at least this many pushes will succeed */
+static inline uint32_t LfRingFree(struct lf_ring *r)
+{
+	return r->size - (r->head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE));
+}
+
+/* Consumer. Returns 0 if Ok, -1 if the ring is empty */
+static inline int LfRingPop(struct lf_ring *r, void *e)
+{
+	uint32_t tail = r->tail;
+
+	if(__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == tail)
+		return -1;
+	memcpy(e, r->buf + (tail & (r->size - 1)) * r->esize, r->esize);
+	__atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,101 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * 64-bit nanosecond time
+ *
+ * Times and durations are signed 64-bit integer nanoseconds (nstime_t),
+ * which covers +-292 years, so periods and execution times of any
+ * length are handled and differences can be negative.
+ *  - NsAdd and NsDiff saturate instead of wrapping around.
+ *  - NsSubSat clamps negative differences to 0 (durations for the
+ *    histograms).
+ *  - timespec and Xenomai RTIME (ns on Cobalt) convert losslessly in
+ *    both directions, also for negative values (tv_nsec stays in
+ *    [0, 1e9)).
+ * Everything is inlined and safe to call from the real-time path.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __NSTIME_H__
+#define __NSTIME_H__
+
+#include <stdint.h>
+#include <time.h>
+
+typedef int64_t nstime_t;
+
+#define NS_PER_SEC 1000000000LL
+#define NS_PER_MS 1000000LL
+#define NS_PER_US 1000LL
+#define NSTIME_MAX INT64_MAX
+#define NSTIME_MIN INT64_MIN
+
+static inline nstime_t NsFromTs(struct timespec ts)
+{
+	return (nstime_t) ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static inline struct timespec NsToTs(nstime_t ns)
+{
+	struct timespec ts;
+
+	ts.tv_sec = ns / NS_PER_SEC;
+	ts.tv_nsec = ns % NS_PER_SEC;
+	if(ts.tv_nsec < 0) { // Division truncates towards 0
+		ts.tv_nsec += NS_PER_SEC;
+		ts.tv_sec--;
+	}
+	return ts;
+}
+
+/* Current time of clock clk */
+static inline nstime_t NsNow(clockid_t clk)
+{
+	struct timespec ts;
+
+	clock_gettime(clk, &ts);
+	return NsFromTs(ts);
+}
+
+/* a + b, saturated to [NSTIME_MIN, NSTIME_MAX] */
+static inline nstime_t NsAdd(nstime_t a, nstime_t b)
+{
+	nstime_t r;
+
+	if(__builtin_add_overflow(a, b, &r))
+		return b > 0 ? NSTIME_MAX : NSTIME_MIN;
+	return r;
+}
+
+/* a - b (signed), saturated to [NSTIME_MIN, NSTIME_MAX] */
+static inline nstime_t NsDiff(nstime_t a, nstime_t b)
+{
+	nstime_t r;
+
+	if(__builtin_sub_overflow(a, b, &r))
+		return b < 0 ? NSTIME_MAX : NSTIME_MIN;
+	return r;
+}
+
+/* a - b, or 0 if b is after a */
+static inline nstime_t NsSubSat(nstime_t a, nstime_t b)
+{
+	nstime_t r = NsDiff(a, b);
+
+	return r > 0 ? r : 0;
+}
+
+/* Xenomai RTIME (unsigned long long ns). SRTIME (long long ns) is already an nstime_t */
+static inline nstime_t NsFromRtime(unsigned long long rt)
+{
+	return rt > (unsigned long long) NSTIME_MAX ? NSTIME_MAX : (nstime_t) rt;
+}
+
+static inline unsigned long long NsToRtime(nstime_t ns)
+{
+	return ns > 0 ? (unsigned long long) ns : 0;
+}
+
+#endif
@@ -0,0 +1,105 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Overrun handling of periodic tasks
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "overrun.h"
+
+// Policy from "skip", "catchup", "degrade" or "abort". Returns -1 if invalid
+int OverrunParse(const char *str)
+{
+	if(!strcmp(str, "skip"))
+		return OVR_SKIP;
+	if(!strcmp(str, "catchup"))
+		return OVR_CATCHUP;
+	if(!strcmp(str, "degrade"))
+		return OVR_DEGRADE;
+	if(!strcmp(str, "abort"))
+		return OVR_ABORT;
+	return -1;
+}
+
+const char *OverrunName(int policy)
+{
+	switch(policy) {
+		case OVR_SKIP: return "skip";
+		case OVR_CATCHUP: return "catchup";
+		case OVR_DEGRADE: return "degrade";
+		case OVR_ABORT: return "abort";
+	}
+	return "?";
+}
+
+void OverrunInit(struct overrun *o, int policy)
+{
+	memset(o, 0, sizeof(*o));
+	o->policy = policy;
+	HistInit(&o->recovery);
+}
+
+// After each wait for the period, with its result and overrun count. Returns the jobs to run now
+// (0 if aborted, more than 1 to catch up) or the error of the wait if it is not an overrun
+int OverrunCheck(struct overrun *o, int err, unsigned long overruns, nstime_t now)
+{
+	int jobs = 1;
+
+	if(err == 0) {
+		/* On time: end of the episode */
+		if(o->since) {
+			HistRecord(&o->recovery, NsSubSat(now, o->since));
+			o->since = 0;
+		}
+		return 1;
+	}
+	if(err != -ETIMEDOUT)
+		return err;
+
+	o->overruns++;
+	o->missed += overruns;
+	if(!o->since)
+		o->since = now;
+
+	switch(o->policy) {
+		case OVR_CATCHUP:
+			jobs += overruns < OVR_CATCHUP_MAX ? overruns : OVR_CATCHUP_MAX;
+			o->extra += jobs - 1;
+			break;
+		case OVR_DEGRADE:
+			o->degrade_left = OVR_DEGRADE_JOBS;
+			break;
+		case OVR_ABORT:
+			o->aborted++;
+			jobs = 0;
+			break;
+	}
+	return jobs;
+}
+
+// Workload scale of the next job: 1, or OVR_DEGRADE_SCALE after an overrun with degrade
+double OverrunScale(struct overrun *o)
+{
+	if(o->degrade_left == 0)
+		return 1;
+	o->degrade_left--;
+	o->degraded++;
+	return OVR_DEGRADE_SCALE;
+}
+
+// Prints the overrun counters of a task (not used in the real-time path)
+void OverrunPrint(const struct overrun *o, const char *name)
+{
+	char label[80];
+
+	printf("Task %s: overrun policy %s / overruns: %lu / missed releases: %lu / extra jobs: %lu / degraded jobs: %lu"
+		" / aborted jobs: %lu\n\r", name, OverrunName(o->policy), o->overruns, o->missed, o->extra, o->degraded, o->aborted);
+	snprintf(label, sizeof(label), "  %s recovery time", name);
+	HistPrint(&o->recovery, label);
+}
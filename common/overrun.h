@@ -0,0 +1,65 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Overrun handling of periodic tasks
+ *
+ * rt_task_wait_period() fails with -ETIMEDOUT when the task missed
+ * release points, and gives their number in overruns. Instead of
+ * ending the task, OverrunCheck() applies a policy:
+ *  - skip: the missed releases are lost, the current one runs
+ *  - catchup: the missed jobs run back-to-back with the current one,
+ *    at most OVR_CATCHUP_MAX of them (the rest are skipped)
+ *  - degrade: the current job and the next OVR_DEGRADE_JOBS - 1 run
+ *    with OVR_DEGRADE_SCALE of the workload, to drain the overload
+ *  - abort: the current job is not run, the task waits for the next
+ *    release
+ * Per task it counts the overruns (late waits), the missed releases,
+ * the extra, degraded and aborted jobs, and the recovery time: from
+ * the first overrun of an episode to the first wait that is on time
+ * again.
+ *
+ * Any other error of the wait is returned as is (the task must stop).
+ * Plain counters and a histogram, called from the task only.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __OVERRUN_H__
+#define __OVERRUN_H__
+
+#include <stdint.h>
+
+#include "hist.h"
+#include "nstime.h"
+
+/* Policies */
+#define OVR_SKIP 0
+#define OVR_CATCHUP 1
+#define OVR_DEGRADE 2
+#define OVR_ABORT 3
+
+#define OVR_CATCHUP_MAX 4		// Missed jobs run by catchup per overrun
+#define OVR_DEGRADE_JOBS 10		// Degraded jobs per overrun
+#define OVR_DEGRADE_SCALE 0.5	// Workload of a degraded job
+
+struct overrun {
+	int policy;
+	uint64_t overruns;		// Waits that reported missed releases
+	uint64_t missed;		// Missed releases
+	uint64_t extra;			// Catchup: missed jobs run
+	uint64_t degraded;		// Degrade: jobs run with the reduced workload
+	uint64_t aborted;		// Abort: jobs not run
+	int degrade_left;		// Degraded jobs still to run
+	nstime_t since;			// First overrun of the current episode, 0 if none
+	struct hist recovery;	// Episode length (ns)
+};
+
+int OverrunParse(const char *str);
+const char *OverrunName(int policy);
+void OverrunInit(struct overrun *o, int policy);
+int OverrunCheck(struct overrun *o, int err, unsigned long overruns, nstime_t now);
+double OverrunScale(struct overrun *o);
+void OverrunPrint(const struct overrun *o, const char *name);
+
+#endif
@@ -0,0 +1,132 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Partitioning of fixed priority tasks to cores
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <string.h>
+
+#include "partition.h"
+
+#define PART_MAX_TASKS 64		// Tasks per call
+#define PART_MAX_CORES 64		// Cores considered
+
+// Returns 1 if tasks i and j use a common resource
+static int PartShare(const struct an_task *t, int i, int j)
+{
+	int a, b;
+
+	for(a = 0; a < t[i].ncs; a++)
+		for(b = 0; b < t[j].ncs; b++)
+			if(!strcmp(t[i].cs[a].res, t[j].cs[b].res))
+				return 1;
+	return 0;
+}
+
+// Places the tasks of group g on core c. Returns 0 if the core remains schedulable, otherwise undoes it
+static int PartTry(struct an_task *t, int n, const int *group, int g, int c, int protocol)
+{
+	int i;
+
+	for(i = 0; i < n; i++)
+		if(group[i] == g)
+			t[i].core = c;
+	if(AnResponseTimes(t, n, c, protocol) == 0)
+		return 0;
+
+	for(i = 0; i < n; i++)
+		if(group[i] == g)
+			t[i].core = PART_AUTO;
+	AnResponseTimes(t, n, c, protocol); // Restore B and R of the core
+	return -1;
+}
+
+// Assigns a core (0..ncores-1) to the tasks with core PART_AUTO. The other tasks keep their core.
+// Returns the number of tasks that could not be placed (left with PART_AUTO)
+int Partition(struct an_task *t, int n, int ncores, int heuristic, int protocol)
+{
+	int group[PART_MAX_TASKS];		// Tasks linked by shared resources form one group
+	double gutil[PART_MAX_TASKS];	// Utilization of each group
+	double cutil[PART_MAX_CORES];	// Utilization of each core
+	int tried[PART_MAX_CORES];
+	int i, j, k, g, c, best, fixed, placed, unplaced = 0;
+
+	if(n > PART_MAX_TASKS)
+		return n;
+	if(ncores > PART_MAX_CORES)
+		ncores = PART_MAX_CORES;
+
+	/* Group the tasks, a group with a task already assigned stays on that core */
+	for(i = 0; i < n; i++)
+		group[i] = i;
+	for(i = 0; i < n; i++)
+		for(j = i + 1; j < n; j++)
+			if(group[j] != group[i] && PartShare(t, i, j))
+				for(g = group[j], k = 0; k < n; k++)
+					if(group[k] == g)
+						group[k] = group[i];
+
+	for(i = 0; i < n; i++) {
+		gutil[i] = 0;
+		fixed = -1;
+		for(j = 0; j < n; j++) {
+			if(group[j] != i)
+				continue;
+			gutil[i] += (double) t[j].C / t[j].T;
+			if(t[j].core != PART_AUTO)
+				fixed = t[j].core;
+		}
+		if(fixed >= 0)
+			for(j = 0; j < n; j++)
+				if(group[j] == i)
+					t[j].core = fixed;
+	}
+
+	for(c = 0; c < ncores; c++)
+		cutil[c] = AnUtilization(t, n, c);
+
+	/* Place the groups by decreasing utilization */
+	while(1) {
+		for(g = -1, i = 0; i < n; i++)
+			if(group[i] == i && t[i].core == PART_AUTO && (g < 0 || gutil[i] > gutil[g]))
+				g = i;
+		if(g < 0)
+			break;
+
+		memset(tried, 0, sizeof(tried));
+		for(placed = 0; !placed; ) {
+			best = -1;
+			for(c = 0; c < ncores; c++) {
+				if(tried[c])
+					continue;
+				if(best < 0 || (heuristic == PART_WFD && cutil[c] < cutil[best]))
+					best = c;
+				if(heuristic == PART_FFD)
+					break;
+			}
+			if(best < 0)
+				break; // No core fits the group
+			tried[best] = 1;
+			if(PartTry(t, n, group, g, best, protocol) == 0) {
+				cutil[best] += gutil[g];
+				placed = 1;
+			}
+		}
+
+		if(!placed)
+			for(i = 0; i < n; i++)
+				if(group[i] == g) {
+					group[i] = -1; // Left unplaced
+					unplaced++;
+				}
+	}
+	return unplaced;
+}
+
+const char *PartitionName(int heuristic)
+{
+	return heuristic == PART_FFD ? "first-fit decreasing" : "worst-fit decreasing";
+}
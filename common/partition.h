@@ -0,0 +1,31 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Partitioning of fixed priority tasks to cores
+ *
+ * Bin-packing with a schedulability test per bin: tasks are taken by
+ * decreasing utilization and placed on the first core (first-fit) or
+ * on the least loaded core (worst-fit) where the response time
+ * analysis (analysis.h) still finds no deadline miss.
+ * Tasks that share a resource are placed together on the same core,
+ * so the uniprocessor blocking terms stay valid.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __PARTITION_H__
+#define __PARTITION_H__
+
+#include "analysis.h"
+
+#define PART_AUTO -1		// an_task.core of the tasks to be placed
+
+/* Heuristics */
+#define PART_FFD 0			// First-fit decreasing (packs the lowest cores)
+#define PART_WFD 1			// Worst-fit decreasing (balances the load)
+
+int Partition(struct an_task *t, int n, int ncores, int heuristic, int protocol);
+const char *PartitionName(int heuristic);
+
+#endif
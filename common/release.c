@@ -0,0 +1,205 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Job release: waits until the absolute release instant of a job
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+
+#include "release.h"
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid	// Not exported by older glibc
+#endif
+
+// Parses "sleep", "hybrid", "hybrid:GUARD" (GUARD in us, or with the suffix ns or us), "timer" or "timerfd".
+// Returns 0 if Ok
+int ReleaseParse(const char *str, struct release_cfg *cfg)
+{
+	char *end;
+	double v;
+
+	memset(cfg, 0, sizeof(*cfg));
+	if(!strcmp(str, "sleep")) {
+		cfg->mode = REL_SLEEP;
+		return 0;
+	}
+	if(!strcmp(str, "timer")) {
+		cfg->mode = REL_TIMER;
+		return 0;
+	}
+	if(!strcmp(str, "timerfd")) {
+		cfg->mode = REL_TIMERFD;
+		return 0;
+	}
+	if(strncmp(str, "hybrid", 6))
+		return -1;
+	cfg->mode = REL_HYBRID;
+	if(str[6] == '\0')
+		return 0; // Auto-tuned guard band
+	if(str[6] != ':')
+		return -1;
+
+	v = strtod(str + 7, &end);
+	if(end == str + 7 || v <= 0)
+		return -1;
+	if(*end == '\0' || !strcmp(end, "us"))
+		v *= 1e3;
+	else if(strcmp(end, "ns"))
+		return -1;
+	cfg->guard = (uint64_t) (v + 0.5);
+	return cfg->guard ? 0 : -1;
+}
+
+void ReleaseInit(struct release *r, const struct release_cfg *cfg)
+{
+	memset(r, 0, sizeof(*r));
+	r->cfg = *cfg;
+	r->guard = cfg->guard ? cfg->guard : REL_GUARD_INIT;
+	HistInit(&r->wake);
+	HistInit(&r->spin);
+	HistInit(&r->cost);
+	r->fd = -1;
+}
+
+// Creates the timer of the timer back-ends. Must run in the waiting thread. On error falls back to sleep
+static void ReleaseSetup(struct release *r)
+{
+	struct sigevent sev;
+	sigset_t sigset;
+
+	r->ready = 1;
+	if(r->cfg.mode == REL_TIMER) {
+		/* The signal is only accepted by sigwaitinfo() */
+		sigemptyset(&sigset);
+		sigaddset(&sigset, REL_SIGNAL);
+		pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+		memset(&sev, 0, sizeof(sev));
+		sev.sigev_notify = SIGEV_THREAD_ID;
+		sev.sigev_signo = REL_SIGNAL;
+		sev.sigev_notify_thread_id = syscall(SYS_gettid);
+		if(timer_create(CLOCK_MONOTONIC, &sev, &r->timer)) {
+			printf("timer_create failed [%s], release falls back to sleep\n\r", strerror(errno));
+			r->cfg.mode = REL_SLEEP;
+		}
+	} else if(r->cfg.mode == REL_TIMERFD) {
+		r->fd = timerfd_create(CLOCK_MONOTONIC, 0);
+		if(r->fd < 0) {
+			printf("timerfd_create failed [%s], release falls back to sleep\n\r", strerror(errno));
+			r->cfg.mode = REL_SLEEP;
+		}
+	}
+}
+
+// Guard band from the wake-up latency observed so far
+static void ReleaseTune(struct release *r)
+{
+	uint64_t g = HistPercentile(&r->wake, REL_TUNE_PCT);
+
+	g += g * REL_TUNE_MARGIN / 100;
+	if(g < REL_GUARD_MIN)
+		g = REL_GUARD_MIN;
+	if(g > REL_GUARD_MAX)
+		g = REL_GUARD_MAX;
+	r->guard = g;
+	r->tunes++;
+}
+
+// Returns at the release instant rel (absolute ns, CLOCK_MONOTONIC) or as soon as possible after it
+void ReleaseWait(struct release *r, nstime_t rel)
+{
+	struct timespec tw;
+	struct itimerspec its;
+	sigset_t sigset;
+	nstime_t w, t, spin_start, c0;
+	uint64_t expirations;
+
+	/* Set up and tune before sleeping, so that work is not added to the release */
+	if(!r->ready)
+		ReleaseSetup(r);
+	if(r->cfg.mode == REL_HYBRID && r->cfg.guard == 0 && r->wake.count >= (r->tunes + 1) * REL_TUNE_EVERY)
+		ReleaseTune(r);
+	c0 = NsNow(CLOCK_THREAD_CPUTIME_ID);
+
+	/* Wait until the release instant (or the start of the guard band, hybrid) */
+	w = rel;
+	if(r->cfg.mode == REL_HYBRID)
+		w = NsDiff(rel, r->guard);
+	tw = NsToTs(w);
+	switch(r->cfg.mode) {
+		case REL_TIMER:
+			memset(&its, 0, sizeof(its));
+			its.it_value = tw; // One shot, absolute
+			sigemptyset(&sigset);
+			sigaddset(&sigset, REL_SIGNAL);
+			timer_settime(r->timer, TIMER_ABSTIME, &its, NULL);
+			while(sigwaitinfo(&sigset, NULL) < 0 && errno == EINTR);
+			break;
+		case REL_TIMERFD:
+			memset(&its, 0, sizeof(its));
+			its.it_value = tw;
+			timerfd_settime(r->fd, TFD_TIMER_ABSTIME, &its, NULL);
+			while(read(r->fd, &expirations, sizeof(expirations)) < 0 && errno == EINTR);
+			break;
+		default:
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tw, NULL);
+	}
+	t = NsNow(CLOCK_MONOTONIC);
+	HistRecord(&r->wake, NsSubSat(t, w));
+
+	/* Hybrid: busy-poll the clock until the release instant */
+	if(r->cfg.mode == REL_HYBRID) {
+		if(t > rel)
+			r->late++;
+		spin_start = t;
+		while(t < rel)
+			t = NsNow(CLOCK_MONOTONIC);
+		HistRecord(&r->spin, t - spin_start);
+	}
+
+	HistRecord(&r->cost, NsSubSat(NsNow(CLOCK_THREAD_CPUTIME_ID), c0));
+}
+
+const char *ReleaseName(const struct release_cfg *cfg)
+{
+	switch(cfg->mode) {
+		case REL_HYBRID: return "hybrid";
+		case REL_TIMER: return "timer";
+		case REL_TIMERFD: return "timerfd";
+		default: return "sleep";
+	}
+}
+
+// Prints the release statistics (not used in the real-time path)
+void ReleasePrint(const struct release *r, const char *name)
+{
+	char label[80];
+
+	if(r->cfg.mode == REL_HYBRID)
+		printf("  %s release: hybrid / guard band: %lu ns (%s, %lu updates) / late wake-ups: %lu\n\r",
+			name, r->guard, r->cfg.guard ? "fixed" : "auto", r->tunes, r->late);
+	else
+		printf("  %s release: %s\n\r", name, ReleaseName(&r->cfg));
+
+	snprintf(label, sizeof(label), "  %s wake-up latency", name);
+	HistPrint(&r->wake, label);
+	if(r->cfg.mode == REL_HYBRID) {
+		snprintf(label, sizeof(label), "  %s busy-polling", name);
+		HistPrint(&r->spin, label);
+	}
+	snprintf(label, sizeof(label), "  %s release CPU time", name);
+	HistPrint(&r->cost, label);
+}
@@ -0,0 +1,82 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Job release: waits until the absolute release instant of a job
+ *
+ * Modes (back-ends):
+ *  - sleep: a single clock_nanosleep(TIMER_ABSTIME). Timer slack and
+ *    wake-up latency add to the activation time.
+ *  - timer: a POSIX timer (timer_create) armed at the release instant,
+ *    delivering REL_SIGNAL to the waiting thread only (SIGEV_THREAD_ID),
+ *    which waits for it with sigwaitinfo().
+ *  - timerfd: a timerfd armed at the release instant, waited with read().
+ *  - hybrid: sleeps until a guard band before the release instant and
+ *    then busy-polls the clock until the exact instant. Trades CPU time
+ *    (the busy-polling) for release jitter.
+ *    With a fixed guard band ("hybrid:20us") or auto-tuned ("hybrid"):
+ *    every REL_TUNE_EVERY wake-ups the guard band is set to the
+ *    REL_TUNE_PCT percentile of the observed wake-up latency plus
+ *    REL_TUNE_MARGIN percent, within [REL_GUARD_MIN, REL_GUARD_MAX].
+ * For every back-end the wake-up latency (jitter) and the CPU time of the
+ * thread spent in ReleaseWait() (syscall overhead: arming, waking up
+ * and, for hybrid, busy-polling) are kept in histograms, so the
+ * back-ends can be compared on each kernel.
+ * The timers of the timer back-ends are created by the waiting thread
+ * on its first release.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __RELEASE_H__
+#define __RELEASE_H__
+
+#include <stdint.h>
+#include <time.h>
+#include <signal.h>
+
+#include "hist.h"
+#include "nstime.h"
+
+/* Modes */
+#define REL_SLEEP 0
+#define REL_HYBRID 1
+#define REL_TIMER 2
+#define REL_TIMERFD 3
+
+#define REL_SIGNAL SIGRTMIN		// Signal of the timer back-end
+
+#define REL_GUARD_INIT 100000	// Guard band until the first tuning (ns)
+#define REL_GUARD_MIN 2000		// Smallest tuned guard band (ns)
+#define REL_GUARD_MAX 500000	// Largest tuned guard band (ns), bounds the busy-polling CPU time
+#define REL_TUNE_EVERY 64		// Wake-ups between tunings
+#define REL_TUNE_PCT 99.9		// Wake-up latency percentile covered by the guard band
+#define REL_TUNE_MARGIN 25		// Extra guard band (% of the percentile)
+
+/* Release configuration, as parsed from "sleep", "hybrid", "hybrid:GUARD", "timer" or "timerfd" */
+struct release_cfg {
+	int mode;
+	uint64_t guard;			// Guard band (ns), 0 = auto-tuned
+};
+
+struct release {
+	struct release_cfg cfg;
+	uint64_t guard;			// Current guard band (ns)
+	uint64_t late;			// Hybrid wake-ups after the release instant (guard band too small)
+	uint64_t tunes;			// Guard band updates
+	struct hist wake;		// Wake-up latency of the sleep (ns after the programmed instant)
+	struct hist spin;		// Busy-polling time per release (ns)
+	struct hist cost;		// Thread CPU time per release (ns)
+	/* Timer back-ends, set up on the first release */
+	int ready;
+	timer_t timer;
+	int fd;
+};
+
+int ReleaseParse(const char *str, struct release_cfg *cfg);
+void ReleaseInit(struct release *r, const struct release_cfg *cfg);
+void ReleaseWait(struct release *r, nstime_t rel);
+void ReleasePrint(const struct release *r, const char *name);
+const char *ReleaseName(const struct release_cfg *cfg);
+
+#endif
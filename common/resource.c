@@ -0,0 +1,204 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Shared resources: mutexes with a resource access protocol and
+ * blocking time metrics
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "resource.h"
+
+// Protocol from "none", "pip" or "pcp". Returns -1 if invalid
+int ResParse(const char *str)
+{
+	if(!strcmp(str, "none"))
+		return RES_NONE;
+	if(!strcmp(str, "pip"))
+		return RES_PIP;
+	if(!strcmp(str, "pcp"))
+		return RES_PCP;
+	return -1;
+}
+
+const char *ResName(int protocol)
+{
+	switch(protocol) {
+		case RES_NONE: return "none";
+		case RES_PIP: return "pip";
+		case RES_PCP: return "pcp";
+	}
+	return "?";
+}
+
+// Creates the lock of a resource. ceiling is the highest priority of its users (pcp only). Returns 0 if Ok
+int ResInit(struct resource *r, const char *name, int protocol, int ceiling)
+{
+	int err;
+#ifndef RES_ALCHEMY
+	pthread_mutexattr_t mattr;
+#endif
+
+	memset(r, 0, sizeof(*r));
+	snprintf(r->name, RES_NAME_LEN, "%s", name);
+	r->protocol = protocol;
+	r->ceiling = ceiling;
+	ResReset(r);
+
+#ifdef RES_ALCHEMY
+	/* Cobalt mutexes always inherit: none needs a semaphore */
+	if(protocol == RES_NONE)
+		err = rt_sem_create(&r->sem, NULL, 1, S_FIFO);
+	else
+		err = rt_mutex_create(&r->mutex, NULL);
+#else
+	pthread_mutexattr_init(&mattr);
+	err = pthread_mutexattr_setprotocol(&mattr, protocol == RES_PIP ? PTHREAD_PRIO_INHERIT :
+		protocol == RES_PCP ? PTHREAD_PRIO_PROTECT : PTHREAD_PRIO_NONE);
+	if(!err && protocol == RES_PCP)
+		err = pthread_mutexattr_setprioceiling(&mattr, ceiling);
+	if(!err)
+		err = pthread_mutex_init(&r->mutex, &mattr);
+	pthread_mutexattr_destroy(&mattr);
+#endif
+	if(err) {
+		printf("Error creating resource %s (%s, ceiling %d) [%s]\n\r", name, ResName(protocol), ceiling,
+			strerror(err < 0 ? -err : err));
+		return -1;
+	}
+	return 0;
+}
+
+#ifdef RES_ALCHEMY
+// Tries to take the lock. Returns 0 if it was taken, else waits for it and returns 1
+static int ResAcquire(struct resource *r)
+{
+	RT_TASK_INFO info;
+
+	if(r->protocol == RES_NONE) {
+		if(rt_sem_p(&r->sem, TM_NONBLOCK) == 0)
+			return 0;
+		rt_sem_p(&r->sem, TM_INFINITE);
+		return 1;
+	}
+
+	/* Immediate ceiling: raise first, so no task of the same ceiling can preempt us in the critical section */
+	if(r->protocol == RES_PCP) {
+		rt_task_inquire(NULL, &info);
+		if(info.prio < r->ceiling)
+			rt_task_set_priority(NULL, r->ceiling);
+		if(rt_mutex_acquire(&r->mutex, TM_NONBLOCK) == 0) {
+			r->saved_prio = info.prio;
+			return 0;
+		}
+		rt_mutex_acquire(&r->mutex, TM_INFINITE);
+		r->saved_prio = info.prio;
+		return 1;
+	}
+
+	if(rt_mutex_acquire(&r->mutex, TM_NONBLOCK) == 0)
+		return 0;
+	rt_mutex_acquire(&r->mutex, TM_INFINITE);
+	return 1;
+}
+
+static void ResRelease(struct resource *r)
+{
+	int prio;
+
+	if(r->protocol == RES_NONE) {
+		rt_sem_v(&r->sem);
+		return;
+	}
+	prio = r->saved_prio;
+	rt_mutex_release(&r->mutex);
+	if(r->protocol == RES_PCP && prio < r->ceiling)
+		rt_task_set_priority(NULL, prio);
+}
+#else
+static int ResAcquire(struct resource *r)
+{
+	if(pthread_mutex_trylock(&r->mutex) == 0)
+		return 0;
+	pthread_mutex_lock(&r->mutex);
+	return 1;
+}
+
+static void ResRelease(struct resource *r)
+{
+	pthread_mutex_unlock(&r->mutex);
+}
+#endif
+
+// Enters the critical section. The wait is added to the current job of u (may be NULL)
+void ResLock(struct resource *r, struct res_user *u)
+{
+	nstime_t t0, t1;
+	int busy;
+
+	t0 = NsNow(CLOCK_MONOTONIC);
+	busy = ResAcquire(r);
+	t1 = NsNow(CLOCK_MONOTONIC);
+
+	/* Holding the lock: the statistics of the resource have a single writer */
+	r->acquired = t1;
+	r->locks++;
+	r->contended += busy;
+	HistRecord(&r->wait, NsSubSat(t1, t0));
+	if(u != NULL)
+		u->job += NsSubSat(t1, t0);
+}
+
+// Leaves the critical section
+void ResUnlock(struct resource *r)
+{
+	HistRecord(&r->hold, NsSubSat(NsNow(CLOCK_MONOTONIC), r->acquired));
+	ResRelease(r);
+}
+
+void ResUserInit(struct res_user *u)
+{
+	u->job = 0;
+	HistInit(&u->block);
+}
+
+// Clears the statistics (e.g. after warm-up)
+void ResReset(struct resource *r)
+{
+	r->locks = r->contended = 0;
+	HistInit(&r->wait);
+	HistInit(&r->hold);
+}
+
+// Prints the statistics of a resource (not used in the real-time path)
+void ResPrint(const struct resource *r)
+{
+	char label[80];
+
+	printf("Resource %s: %s", r->name, ResName(r->protocol));
+	if(r->protocol == RES_PCP)
+		printf(" (ceiling %d)", r->ceiling);
+	printf(" / locks: %lu / contended: %lu / worst-case blocking: %lu ns\n\r", r->locks, r->contended,
+		r->protocol == RES_PCP ? r->hold.max : r->wait.max);
+	snprintf(label, sizeof(label), "  %s lock wait", r->name);
+	HistPrint(&r->wait, label);
+	snprintf(label, sizeof(label), "  %s critical section", r->name);
+	HistPrint(&r->hold, label);
+}
+
+// Prints the blocking time per job of a task (not used in the real-time path)
+void ResUserPrint(const struct res_user *u, const char *name)
+{
+	char label[80];
+
+	snprintf(label, sizeof(label), "  %s blocking per job", name);
+	HistPrint(&u->block, label);
+}
@@ -0,0 +1,103 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Shared resources: mutexes with a resource access protocol and
+ * blocking time metrics
+ *
+ * Protocols:
+ *  - none: plain mutual exclusion, no protection against priority
+ *    inversion (like a binary semaphore)
+ *  - pip: priority inheritance, the holder runs with the highest
+ *    priority of the tasks it blocks
+ *  - pcp: immediate priority ceiling, the holder runs with the ceiling
+ *    of the resource (highest priority of its users) for the whole
+ *    critical section, so a task is blocked at most once, before it
+ *    starts, and never at the lock itself on a single core
+ * Back-ends, chosen at compile time:
+ *  - POSIX threads (lab1): pthread mutex with PTHREAD_PRIO_NONE,
+ *    PTHREAD_PRIO_INHERIT or PTHREAD_PRIO_PROTECT
+ *  - Xenomai alchemy (lab2, built with xeno-config, which defines
+ *    __COBALT__ or __MERCURY__): RT_MUTEX, which always inherits; pcp
+ *    raises the task to the ceiling around it and none is a binary
+ *    RT_SEM
+ *
+ * Metrics:
+ *  - per resource: lock waits (request to acquisition, the direct
+ *    blocking the resource causes), contended locks and critical
+ *    section lengths. Under pcp the blocking happens before the job
+ *    starts and is bounded by the longest critical section, which is
+ *    reported as the worst-case blocking of the resource.
+ *  - per task (res_user): lock waits summed over each job, closed by
+ *    ResJobEnd(), to compare with the blocking term B of the response
+ *    time analysis (analysis.h).
+ * Lock and unlock record into histograms, nothing is allocated.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __RESOURCE_H__
+#define __RESOURCE_H__
+
+#include <stdint.h>
+
+#if defined(__COBALT__) || defined(__MERCURY__)
+#define RES_ALCHEMY
+#include <alchemy/task.h>
+#include <alchemy/mutex.h>
+#include <alchemy/sem.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "hist.h"
+#include "nstime.h"
+
+/* Protocols */
+#define RES_NONE 0
+#define RES_PIP 1
+#define RES_PCP 2
+
+#define RES_NAME_LEN 32
+
+struct resource {
+	char name[RES_NAME_LEN];
+	int protocol;
+	int ceiling;			// Highest priority of the users (pcp)
+#ifdef RES_ALCHEMY
+	RT_MUTEX mutex;			// pip, pcp
+	RT_SEM sem;				// none
+	int saved_prio;			// pcp: priority of the holder before the lock
+#else
+	pthread_mutex_t mutex;
+#endif
+	nstime_t acquired;		// Acquisition instant of the current holder
+	uint64_t locks;
+	uint64_t contended;		// Locks that found the resource taken
+	struct hist wait;		// Request to acquisition (ns)
+	struct hist hold;		// Critical section length (ns)
+};
+
+struct res_user {
+	nstime_t job;			// Lock waits of the current job
+	struct hist block;		// Lock waits per job (ns)
+};
+
+int ResParse(const char *str);
+const char *ResName(int protocol);
+int ResInit(struct resource *r, const char *name, int protocol, int ceiling);
+void ResLock(struct resource *r, struct res_user *u);
+void ResUnlock(struct resource *r);
+void ResUserInit(struct res_user *u);
+void ResReset(struct resource *r);
+void ResPrint(const struct resource *r);
+void ResUserPrint(const struct res_user *u, const char *name);
+
+/* Closes the blocking time of one job. Called from the real-time path */
+static inline void ResJobEnd(struct res_user *u)
+{
+	HistRecord(&u->block, u->job);
+	u->job = 0;
+}
+
+#endif
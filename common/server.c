@@ -0,0 +1,177 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Aperiodic servers: bounded execution of sporadic event streams
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "server.h"
+
+#define HELD_BUDGET 1	// The current job waited for a replenishment
+#define HELD_MIN_IA 2	// The current job waited for min_ia
+
+// Kind from "none", "sporadic" or "deferrable". Returns -1 if invalid
+int ServerParse(const char *str)
+{
+	if(!strcmp(str, "none"))
+		return SRV_NONE;
+	if(!strcmp(str, "sporadic"))
+		return SRV_SPORADIC;
+	if(!strcmp(str, "deferrable"))
+		return SRV_DEFERRABLE;
+	return -1;
+}
+
+const char *ServerName(int kind)
+{
+	switch(kind) {
+		case SRV_NONE: return "none";
+		case SRV_SPORADIC: return "sporadic";
+		case SRV_DEFERRABLE: return "deferrable";
+	}
+	return "?";
+}
+
+// Full budget at now. budget, period and min_ia are ignored with SRV_NONE
+void ServerInit(struct server *s, int kind, nstime_t budget, nstime_t period, nstime_t min_ia, nstime_t now)
+{
+	memset(s, 0, sizeof(*s));
+	s->kind = kind;
+	s->budget = budget;
+	s->period = period;
+	s->min_ia = kind == SRV_NONE ? 0 : min_ia;
+	s->capacity = budget;
+	s->refill = NsAdd(now, period);
+	LfRingInit(&s->queue, s->queue_buf, SRV_QUEUE_LEN, sizeof(nstime_t));
+	HistInit(&s->delay);
+	HistInit(&s->response);
+}
+
+// Producer: queues an event. Returns 0 if Ok, -1 if the queue is full (dropped)
+int ServerArrive(struct server *s, nstime_t now)
+{
+	s->arrivals++;
+	if(LfRingPush(&s->queue, &now)) {
+		s->dropped++;
+		return -1;
+	}
+	return 0;
+}
+
+// Server task: oldest queued event. Returns 0 if Ok, -1 if none
+int ServerNext(struct server *s, nstime_t *arrival)
+{
+	return LfRingPop(&s->queue, arrival);
+}
+
+// Gives back the budget due at now
+static void ServerReplenish(struct server *s, nstime_t now)
+{
+	struct srv_repl *r;
+
+	if(s->kind == SRV_DEFERRABLE) {
+		/* An overrun of the previous period is taken from the new budget */
+		while(now >= s->refill) {
+			s->capacity = s->budget + (s->capacity < 0 ? s->capacity : 0);
+			s->refill = NsAdd(s->refill, s->period);
+		}
+		return;
+	}
+	while(s->repl_count > 0) {
+		r = &s->repl[s->repl_first];
+		if(r->at > now)
+			break;
+		s->capacity += r->amount;
+		s->repl_first = (s->repl_first + 1) % SRV_REPL_MAX;
+		s->repl_count--;
+	}
+}
+
+// Server task, before a job of declared cost: returns 0 if it may start now, else the time to check again
+nstime_t ServerAdmit(struct server *s, nstime_t cost, nstime_t now)
+{
+	nstime_t need, at, capacity;
+	int i;
+
+	if(s->kind == SRV_NONE)
+		return 0;
+
+	if(s->last_start && now < NsAdd(s->last_start, s->min_ia)) {
+		if(!(s->held & HELD_MIN_IA))
+			s->throttled++;
+		s->held |= HELD_MIN_IA;
+		return NsAdd(s->last_start, s->min_ia);
+	}
+
+	ServerReplenish(s, now);
+	need = cost < s->budget ? cost : s->budget;
+	if(s->capacity >= need)
+		return 0;
+
+	if(!(s->held & HELD_BUDGET))
+		s->exhausted++;
+	s->held |= HELD_BUDGET;
+	if(s->kind == SRV_DEFERRABLE)
+		return s->refill;
+
+	/* Sporadic: first replenishment that covers the cost (capacity + pending is always the budget) */
+	capacity = s->capacity;
+	at = now;
+	for(i = 0; i < s->repl_count && capacity < need; i++) {
+		at = s->repl[(s->repl_first + i) % SRV_REPL_MAX].at;
+		capacity += s->repl[(s->repl_first + i) % SRV_REPL_MAX].amount;
+	}
+	return at;
+}
+
+// Server task, after a job that executed for used: charges the budget and records the queueing delay and response time
+void ServerDone(struct server *s, nstime_t arrival, nstime_t start, nstime_t end, nstime_t used)
+{
+	struct srv_repl *r;
+
+	s->jobs++;
+	s->held = 0;
+	s->last_start = start;
+	HistRecord(&s->delay, NsSubSat(start, arrival));
+	HistRecord(&s->response, NsSubSat(end, arrival));
+	if(s->kind == SRV_NONE)
+		return;
+
+	s->capacity -= used;
+	if(s->capacity < 0)
+		s->overran++;
+	if(s->kind != SRV_SPORADIC)
+		return;
+
+	/* Given back one period after the start. If full, merged into the last one (later, so still safe) */
+	if(s->repl_count == SRV_REPL_MAX) {
+		r = &s->repl[(s->repl_first + SRV_REPL_MAX - 1) % SRV_REPL_MAX];
+		r->amount += used;
+	} else {
+		r = &s->repl[(s->repl_first + s->repl_count) % SRV_REPL_MAX];
+		r->amount = used;
+		s->repl_count++;
+	}
+	r->at = NsAdd(start, s->period);
+}
+
+// Prints the counters of a server (not used in the real-time path)
+void ServerPrint(const struct server *s, const char *name)
+{
+	char label[80];
+
+	printf("Server %s: %s", name, ServerName(s->kind));
+	if(s->kind != SRV_NONE)
+		printf(" (budget %ld ns / period %ld ns / min inter-arrival %ld ns)", s->budget, s->period, s->min_ia);
+	printf(" / events: %lu / dropped: %lu / jobs: %lu / budget exhausted: %lu / throttled: %lu / over budget: %lu\n\r",
+		s->arrivals, s->dropped, s->jobs, s->exhausted, s->throttled, s->overran);
+	snprintf(label, sizeof(label), "  %s queueing delay", name);
+	HistPrint(&s->delay, label);
+	snprintf(label, sizeof(label), "  %s response time", name);
+	HistPrint(&s->response, label);
+}
@@ -0,0 +1,86 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Aperiodic servers: bounded execution of sporadic event streams
+ *
+ * A task that serves a stream of events (one job per event) gets a
+ * budget of execution time per replenishment period, so a burst of
+ * events cannot take more than budget/period of its core and the tasks
+ * below it keep their guarantees:
+ *  - sporadic: the time a job consumed is given back one period after
+ *    the job started (as POSIX SCHED_SPORADIC). Analyzed as a periodic
+ *    task with C = budget and T = period
+ *  - deferrable: the budget is refilled to its full value at every
+ *    period boundary. Simpler, but two budgets can run back-to-back
+ *    across a boundary (analyzed with a jitter of period - budget)
+ *  - none: no budget, the events are only queued (baseline)
+ * A job starts only if the budget left covers its declared cost and at
+ * least min_ia passed since the previous start (minimum inter-arrival
+ * enforcement, any kind but none). The server does not preempt a job:
+ * what it consumes over the budget is taken from the next replenishment.
+ * Consumption is the execution time of the job given by the caller
+ * (e.g. from the xtime of rt_task_inquire), not its wall time, which
+ * would also charge the preemptions by higher priority tasks.
+ *
+ * Events are queued with their arrival time in a lock-free SPSC ring:
+ * ServerArrive() from the task that produces them, the rest from the
+ * server task only. If the queue is full the event is dropped.
+ * Counts events, drops, jobs, budget exhaustions (jobs that waited for
+ * a replenishment) and throttled jobs (waited for min_ia), with the
+ * queueing delay (arrival to start) and response time (arrival to end)
+ * histograms.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include <stdint.h>
+
+#include "hist.h"
+#include "nstime.h"
+#include "lockfree.h"
+
+/* Kinds */
+#define SRV_NONE 0
+#define SRV_SPORADIC 1
+#define SRV_DEFERRABLE 2
+
+#define SRV_QUEUE_LEN 16		// Queued events per server (power of 2)
+#define SRV_REPL_MAX 16			// Pending replenishments (sporadic)
+
+struct srv_repl {
+	nstime_t at;			// Absolute time
+	nstime_t amount;
+};
+
+struct server {
+	int kind;
+	nstime_t budget, period;	// Execution time per replenishment period (ns)
+	nstime_t min_ia;			// Minimum time between job starts, 0 if none
+	nstime_t capacity;			// Budget left, negative if a job went over it
+	nstime_t refill;			// Deferrable: next period boundary
+	struct srv_repl repl[SRV_REPL_MAX];	// Sporadic: pending replenishments, in time order
+	int repl_first, repl_count;
+	nstime_t last_start;		// Start of the previous job, 0 if none
+	int held;					// The current job already waited (counted once)
+	struct lf_ring queue;		// Arrival times of the events
+	nstime_t queue_buf[SRV_QUEUE_LEN];
+	uint64_t arrivals, dropped;	// Written by the producer
+	uint64_t jobs, exhausted, throttled, overran;
+	struct hist delay;			// Queueing delay (ns)
+	struct hist response;		// Response time (ns)
+};
+
+int ServerParse(const char *str);
+const char *ServerName(int kind);
+void ServerInit(struct server *s, int kind, nstime_t budget, nstime_t period, nstime_t min_ia, nstime_t now);
+int ServerArrive(struct server *s, nstime_t now);
+int ServerNext(struct server *s, nstime_t *arrival);
+nstime_t ServerAdmit(struct server *s, nstime_t cost, nstime_t now);
+void ServerDone(struct server *s, nstime_t arrival, nstime_t start, nstime_t end, nstime_t used);
+void ServerPrint(const struct server *s, const char *name);
+
+#endif
@@ -0,0 +1,40 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Per-task job statistics - reporting
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+
+#include "stats.h"
+
+// Clears the statistics of a task with the given relative deadline (ns)
+void StatsInit(struct job_stats *s, uint64_t deadline)
+{
+	HistInit(&s->iat);
+	HistInit(&s->lat);
+	HistInit(&s->exec);
+	HistInit(&s->resp);
+	s->deadline = deadline;
+	s->jobs = 0;
+	s->misses = 0;
+}
+
+// Prints all the metrics of a task (values in ns)
+void StatsPrint(const struct job_stats *s, const char *name)
+{
+	char label[80];
+
+	printf("Task %s: jobs: %lu / deadline (%lu ns) misses: %lu\n\r", name, s->jobs, s->deadline, s->misses);
+	snprintf(label, sizeof(label), "  %s inter-arrival time", name);
+	HistPrint(&s->iat, label);
+	snprintf(label, sizeof(label), "  %s release lateness", name);
+	HistPrint(&s->lat, label);
+	snprintf(label, sizeof(label), "  %s execution time", name);
+	HistPrint(&s->exec, label);
+	snprintf(label, sizeof(label), "  %s response time", name);
+	HistPrint(&s->resp, label);
+}
@@ -0,0 +1,51 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Per-task job statistics
+ *
+ * For each job keeps separate histograms of
+ *  - inter-arrival time: wake-up minus previous wake-up
+ *  - release lateness: wake-up minus scheduled (absolute) release
+ *  - execution time: completion minus wake-up
+ *  - response time: completion minus scheduled release
+ * and counts the jobs whose response time exceeds the relative deadline.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdint.h>
+
+#include "hist.h"
+#include "nstime.h"
+
+struct job_stats {
+	struct hist iat;	// Inter-arrival time
+	struct hist lat;	// Release lateness
+	struct hist exec;	// Execution time
+	struct hist resp;	// Response time
+	uint64_t deadline;	// Relative deadline (ns)
+	uint64_t jobs;		// Jobs recorded
+	uint64_t misses;	// Jobs that missed the deadline
+};
+
+void StatsInit(struct job_stats *s, uint64_t deadline);
+void StatsPrint(const struct job_stats *s, const char *name);
+
+/* Record one job. Times are absolute, in ns. Called from the real-time path */
+static inline void StatsJob(struct job_stats *s, nstime_t release, nstime_t start, nstime_t end)
+{
+	uint64_t resp = NsSubSat(end, release);
+
+	HistRecord(&s->lat, NsSubSat(start, release));
+	HistRecord(&s->exec, NsSubSat(end, start));
+	HistRecord(&s->resp, resp);
+	s->jobs++;
+	if(resp > s->deadline)
+		s->misses++;
+}
+
+#endif
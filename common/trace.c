@@ -0,0 +1,123 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Lock-free binary event trace - drainer side
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "trace.h"
+
+static struct trace_ring *rings[TRACE_MAX_RINGS];	// Rings served by the drainer
+static unsigned int nrings = 0;
+static FILE *trace_file = NULL;
+static pthread_t drainer;
+static volatile int drainer_stop = 0;
+
+// Clears a ring and registers it in the drainer
+void TraceInit(struct trace_ring *r, uint32_t task)
+{
+	unsigned int n = __atomic_load_n(&nrings, __ATOMIC_ACQUIRE);
+
+	memset(r, 0, sizeof(*r));
+	r->task = task;
+
+	if(n >= TRACE_MAX_RINGS) {
+		printf("Trace: too many rings, task %u will not be traced\n\r", task);
+		return;
+	}
+	rings[n] = r;
+	__atomic_store_n(&nrings, n + 1, __ATOMIC_RELEASE);
+}
+
+// Copies all pending events of every ring to the trace file
+static void TraceDrain(void)
+{
+	unsigned int i, n = __atomic_load_n(&nrings, __ATOMIC_ACQUIRE);
+	uint32_t head, tail, idx, len;
+	struct trace_ring *r;
+
+	for(i = 0; i < n; i++) {
+		r = rings[i];
+		tail = r->tail;
+		head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+		while(tail != head) {
+			idx = tail & (TRACE_RING_SIZE - 1);
+			len = head - tail;
+			if(len > TRACE_RING_SIZE - idx)
+				len = TRACE_RING_SIZE - idx; // Stop at the end of the buffer, wrap on next pass
+			fwrite(&r->ev[idx], sizeof(struct trace_event), len, trace_file);
+			tail += len;
+		}
+		__atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+	}
+}
+
+// Drainer thread body
+static void *TraceDrainer(void *arg)
+{
+	struct timespec tp = {0, TRACE_DRAIN_PERIOD_MS * 1000000L};
+
+	while(!drainer_stop) {
+		TraceDrain();
+		nanosleep(&tp, NULL);
+	}
+	TraceDrain();
+	return NULL;
+}
+
+// Opens the trace file and starts the drainer thread (non real-time)
+int TraceStart(const char *path)
+{
+	struct sched_param parm;
+	pthread_attr_t attr;
+	int err;
+
+	trace_file = fopen(path, "wb");
+	if(trace_file == NULL) {
+		printf("Trace: cannot open %s\n\r", path);
+		return -1;
+	}
+	fwrite(TRACE_MAGIC, 1, strlen(TRACE_MAGIC), trace_file);
+
+	parm.sched_priority = 0;
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+	pthread_attr_setschedparam(&attr, &parm);
+
+	drainer_stop = 0;
+	err = pthread_create(&drainer, &attr, TraceDrainer, NULL);
+	if(err != 0) {
+		printf("Trace: error creating drainer thread [%s]\n\r", strerror(err));
+		fclose(trace_file);
+		trace_file = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+// Flushes the pending events, stops the drainer and reports lost events
+void TraceStop(void)
+{
+	unsigned int i;
+
+	if(trace_file == NULL)
+		return;
+
+	drainer_stop = 1;
+	pthread_join(drainer, NULL);
+	fclose(trace_file);
+	trace_file = NULL;
+
+	for(i = 0; i < nrings; i++)
+		if(rings[i]->dropped)
+			printf("Trace: task %u dropped %u events\n\r", rings[i]->task, rings[i]->dropped);
+}
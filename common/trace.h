@@ -0,0 +1,72 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Lock-free binary event trace
+ *
+ * Each task owns a single-producer/single-consumer ring of fixed size
+ * binary events. The real-time task only stores the event and publishes
+ * the new head index (no locks, no syscalls). A low priority drainer
+ * thread empties all registered rings into a file, which can be decoded
+ * with lab1/tracedump.
+ * If a ring is full the event is dropped and counted, the producer
+ * never waits for the drainer.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+
+#define TRACE_RING_SIZE 1024		// Events per ring (power of 2)
+#define TRACE_MAX_RINGS 64			// Max number of rings served by the drainer
+#define TRACE_DRAIN_PERIOD_MS 50	// Drainer polling period
+#define TRACE_MAGIC "RTTRACE1"		// File header
+
+/* Event types */
+#define TRACE_RELEASE	1	// Job release, payload: inter-arrival time (ns)
+#define TRACE_JOB_END	2	// Job completion, payload: execution time (ns)
+#define TRACE_SEQ		3	// Shared sequence number update, payload: new value
+#define TRACE_OVERRUN	4	// Missed release(s), payload: number of overruns
+
+/* Binary event, written to the file as is */
+struct trace_event {
+	uint64_t ts;		// Timestamp (ns)
+	uint64_t payload;	// Event specific value
+	uint32_t task;		// Task id
+	uint32_t type;		// Event type (TRACE_xxx)
+};
+
+struct trace_ring {
+	uint32_t head __attribute__((aligned(64)));	// Next slot to write (producer only)
+	uint32_t dropped;							// Events lost due to full ring (producer only)
+	uint32_t tail __attribute__((aligned(64)));	// Next slot to read (drainer only)
+	uint32_t task;
+	struct trace_event ev[TRACE_RING_SIZE] __attribute__((aligned(64)));
+};
+
+void TraceInit(struct trace_ring *r, uint32_t task);
+int TraceStart(const char *path);
+void TraceStop(void);
+
+/* Log one event. Called from the real-time path */
+static inline void TraceEmit(struct trace_ring *r, uint64_t ts, uint32_t type, uint64_t payload)
+{
+	uint32_t head = r->head;
+	struct trace_event *e;
+
+	if(head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= TRACE_RING_SIZE) {
+		r->dropped++;
+		return;
+	}
+	e = &r->ev[head & (TRACE_RING_SIZE - 1)];
+	e->ts = ts;
+	e->payload = payload;
+	e->task = r->task;
+	e->type = type;
+	__atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,108 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Real-time warm-up: memory locking, prefaulting and cache priming
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <sys/mman.h>
+
+#include "warmup.h"
+
+// Allocates, touches every page and frees size bytes of heap
+static void WarmupHeap(size_t size)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	volatile char *p = malloc(size);
+	size_t i;
+
+	if(p == NULL)
+		return;
+	for(i = 0; i < size; i += page)
+		p[i] = 0;
+	free((void *) p);
+}
+
+// Touches WARMUP_STACK bytes below the caller frame
+static void __attribute__((noinline)) WarmupStack(void)
+{
+	volatile char buf[WARMUP_STACK];
+	long page = sysconf(_SC_PAGESIZE);
+	size_t i;
+
+	for(i = 0; i < sizeof(buf); i += page)
+		buf[i] = 0;
+}
+
+// Locks the process memory and prefaults the heap. Returns 0 if Ok
+int WarmupProcess(void)
+{
+	if(mlockall(MCL_CURRENT | MCL_FUTURE)) {
+		printf("mlockall failed [%s], memory is not locked\n\r", strerror(errno));
+		return -1;
+	}
+
+	/* Freed memory stays in the (locked) heap instead of going back to the kernel */
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+	WarmupHeap(WARMUP_HEAP);
+	return 0;
+}
+
+// Prefaults the stack and the malloc arena of the calling thread
+void WarmupThread(struct warmup *w)
+{
+	nstime_t t0 = NsNow(CLOCK_MONOTONIC);
+
+	memset(w, 0, sizeof(*w));
+	WarmupStack();
+	WarmupHeap(WARMUP_THREAD_HEAP);
+	w->duration = NsSubSat(NsNow(CLOCK_MONOTONIC), t0);
+}
+
+// Runs work(arg) until WARMUP_WINDOW consecutive execution times agree within WARMUP_TOL percent, at most max times
+void WarmupWork(struct warmup *w, void (*work)(void *arg), void *arg, int max)
+{
+	nstime_t t0 = NsNow(CLOCK_MONOTONIC), t, lo, hi;
+	nstime_t c[WARMUP_WINDOW];
+	int i;
+
+	for(w->runs = 0; w->runs < max && !w->stable; w->runs++) {
+		t = NsNow(CLOCK_MONOTONIC);
+		work(arg);
+		w->exec = NsSubSat(NsNow(CLOCK_MONOTONIC), t);
+		c[w->runs % WARMUP_WINDOW] = w->exec;
+		if(w->runs + 1 < WARMUP_WINDOW)
+			continue;
+
+		lo = hi = c[0];
+		for(i = 1; i < WARMUP_WINDOW; i++) {
+			if(c[i] < lo)
+				lo = c[i];
+			if(c[i] > hi)
+				hi = c[i];
+		}
+		w->stable = (hi - lo) * 100 <= lo * WARMUP_TOL;
+	}
+	w->duration += NsSubSat(NsNow(CLOCK_MONOTONIC), t0);
+}
+
+void WarmupPrint(const struct warmup *w, const char *name)
+{
+	if(w->runs == 0)
+		printf("Warm-up %s: %.3f ms (stack and heap)\n\r", name, w->duration / 1e6);
+	else if(w->runs < WARMUP_WINDOW)
+		printf("Warm-up %s: %.3f ms, %d dry runs, last execution time %ld ns\n\r", name, w->duration / 1e6,
+			w->runs, w->exec);
+	else
+		printf("Warm-up %s: %.3f ms, %d dry runs, execution time %s at %ld ns\n\r", name, w->duration / 1e6,
+			w->runs, w->stable ? "stable" : "NOT stable", w->exec);
+}
@@ -0,0 +1,46 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Real-time warm-up: memory locking, prefaulting and cache priming
+ *
+ * Replaces discarding the first jobs (BOOT_ITER):
+ *  - WarmupProcess(): locks current and future memory (mlockall), keeps
+ *    freed memory in the heap (no trimming, no mmap for large blocks)
+ *    and prefaults WARMUP_HEAP bytes of it. Call once from main().
+ *  - WarmupThread(): prefaults WARMUP_STACK bytes of the calling thread
+ *    stack and WARMUP_THREAD_HEAP bytes of its malloc arena.
+ *  - WarmupWork(): runs the job dry, in the calling thread, until its
+ *    execution time is stable: WARMUP_WINDOW consecutive runs within
+ *    WARMUP_TOL percent of each other (at most max runs).
+ * Both thread functions must run in the real-time thread, before its
+ * first release, so the caches and the stack are the ones it uses.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __WARMUP_H__
+#define __WARMUP_H__
+
+#include "nstime.h"
+
+#define WARMUP_HEAP (8 * 1024 * 1024)			// Process heap prefault (bytes)
+#define WARMUP_STACK (256 * 1024)				// Thread stack prefault (bytes)
+#define WARMUP_THREAD_HEAP (1024 * 1024)		// Thread arena prefault (bytes)
+#define WARMUP_WINDOW 5							// Runs that must agree
+#define WARMUP_TOL 5							// Execution time tolerance (%)
+#define WARMUP_MAX_RUNS 50						// Default limit of dry runs
+
+struct warmup {
+	nstime_t duration;	// Total warm-up time of the thread (ns)
+	nstime_t exec;		// Execution time of the last dry run (ns)
+	int runs;			// Dry runs
+	int stable;			// Execution time stabilized
+};
+
+int WarmupProcess(void);
+void WarmupThread(struct warmup *w);
+void WarmupWork(struct warmup *w, void (*work)(void *arg), void *arg, int max);
+void WarmupPrint(const struct warmup *w, const char *name);
+
+#endif
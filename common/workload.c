@@ -0,0 +1,224 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Synthetic workload: self-calibrated execution times
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "workload.h"
+#include "kernels.h"
+
+static double ns_per_iter;		// Cost of one sub-interval, set by WorkloadCalibrate
+static volatile float sink;		// Keeps the compiler from removing the calibration runs
+static kern_fn kernel;			// Integration kernel, scalar unless WorkloadKernel is called
+
+// Task load: Heavy_Work integration with the selected kernel
+static float WorkloadSpin(long subInterval)
+{
+	return kernel(KERN_LOWER, KERN_UPPER, subInterval);
+}
+
+// Selects the integration kernel (see kernels.h). Call before WorkloadCalibrate. Returns 0 if Ok
+int WorkloadKernel(int k)
+{
+	kern_fn fn = KernGet(k);
+
+	if(fn == NULL)
+		return -1;
+	kernel = fn;
+	return 0;
+}
+
+// Measures the cost of one sub-interval. Call once from main(), before the real-time threads. Returns ns per sub-interval
+double WorkloadCalibrate(void)
+{
+	nstime_t t0, c, best = NSTIME_MAX;
+	int i;
+
+	if(kernel == NULL)
+		kernel = KernGet(KERN_SCALAR);
+	for(i = 0; i < WL_CAL_RUNS; i++) {
+		t0 = NsNow(CLOCK_MONOTONIC);
+		sink = WorkloadSpin(WL_CAL_ITERS);
+		c = NsSubSat(NsNow(CLOCK_MONOTONIC), t0);
+		if(c < best)
+			best = c;
+	}
+	ns_per_iter = (double) best / WL_CAL_ITERS;
+	return ns_per_iter;
+}
+
+// Sub-intervals of the load that take about exec ns on one core
+long WorkloadIters(nstime_t exec)
+{
+	if(ns_per_iter <= 0 || exec <= 0)
+		return 0;
+	return (long) (exec / ns_per_iter + 0.5);
+}
+
+// Runs the load for about exec ns. Returns the integration value
+float WorkloadRun(nstime_t exec)
+{
+	return WorkloadSpin(WorkloadIters(exec));
+}
+
+// Integrates [lower, upper] with n sub-intervals, a slice of a longer job (see forkjoin.h)
+float WorkloadSpan(float lower, float upper, long n)
+{
+	return kernel(lower, upper, n);
+}
+
+// Parses a time (default us) ending at ':' or at the end of the string. Returns 0 if Ok
+static int WorkloadTime(const char *str, const char **next, nstime_t *ns)
+{
+	char *end;
+	double v = strtod(str, &end);
+	size_t len = strcspn(end, ":");
+
+	if(end == str || v < 0)
+		return -1;
+	if(len == 0 || (len == 2 && !strncmp(end, "us", 2)))
+		v *= 1e3;
+	else if(len == 2 && !strncmp(end, "ms", 2))
+		v *= 1e6;
+	else if(len == 1 && *end == 's')
+		v *= 1e9;
+	else if(len != 2 || strncmp(end, "ns", 2))
+		return -1;
+
+	*ns = (nstime_t) (v + 0.5);
+	*next = end + len;
+	return 0;
+}
+
+// Parses a number ending at ':' or at the end of the string. Returns 0 if Ok
+static int WorkloadNumber(const char *str, const char **next, double *v)
+{
+	char *end;
+
+	*v = strtod(str, &end);
+	if(end == str || (*end != '\0' && *end != ':'))
+		return -1;
+	*next = end;
+	return 0;
+}
+
+// Parses C, uniform:LO:HI, bimodal:LO:HI:P or pareto:MIN:ALPHA:MAX. Returns 0 if Ok
+int WorkloadParse(const char *str, struct workload_cfg *cfg)
+{
+	const char *s;
+
+	memset(cfg, 0, sizeof(*cfg));
+	if(!strncmp(str, "uniform:", 8)) {
+		cfg->dist = WL_UNIFORM;
+		s = str + 8;
+		if(WorkloadTime(s, &s, &cfg->lo) || *s++ != ':' || WorkloadTime(s, &s, &cfg->hi) || *s != '\0')
+			return -1;
+	} else if(!strncmp(str, "bimodal:", 8)) {
+		cfg->dist = WL_BIMODAL;
+		s = str + 8;
+		if(WorkloadTime(s, &s, &cfg->lo) || *s++ != ':' || WorkloadTime(s, &s, &cfg->hi) || *s++ != ':'
+				|| WorkloadNumber(s, &s, &cfg->p) || *s != '\0' || cfg->p < 0 || cfg->p > 1)
+			return -1;
+	} else if(!strncmp(str, "pareto:", 7)) {
+		cfg->dist = WL_PARETO;
+		s = str + 7;
+		if(WorkloadTime(s, &s, &cfg->lo) || *s++ != ':' || WorkloadNumber(s, &s, &cfg->p) || *s++ != ':'
+				|| WorkloadTime(s, &s, &cfg->hi) || *s != '\0' || cfg->p <= 0 || cfg->lo == 0)
+			return -1;
+	} else {
+		cfg->dist = WL_CONST;
+		if(WorkloadTime(str, &s, &cfg->lo) || *s != '\0')
+			return -1;
+		cfg->hi = cfg->lo;
+	}
+	return cfg->hi < cfg->lo ? -1 : 0;
+}
+
+// Initializes the generator of a task. seed is used when the configuration has none
+void WorkloadInit(struct workload *w, const struct workload_cfg *cfg, uint64_t seed)
+{
+	uint64_t z;
+
+	w->cfg = *cfg;
+	if(cfg->seed)
+		seed = cfg->seed;
+
+	/* splitmix64 of the seed, never 0 */
+	z = seed + 0x9e3779b97f4a7c15ULL;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	z ^= z >> 31;
+	w->state = z ? z : 1;
+}
+
+// Uniform in [0, 1)
+static double WorkloadRandom(struct workload *w)
+{
+	w->state ^= w->state >> 12;
+	w->state ^= w->state << 25;
+	w->state ^= w->state >> 27;
+	return ((w->state * 0x2545f4914f6cdd1dULL) >> 11) * 0x1.0p-53;
+}
+
+// Draws the execution time of the next job (ns)
+nstime_t WorkloadNext(struct workload *w)
+{
+	const struct workload_cfg *c = &w->cfg;
+	double u, x;
+
+	switch(c->dist) {
+	case WL_UNIFORM:
+		return c->lo + (nstime_t) (WorkloadRandom(w) * (c->hi - c->lo + 1));
+	case WL_BIMODAL:
+		return WorkloadRandom(w) < c->p ? c->hi : c->lo;
+	case WL_PARETO:
+		/* Inverse CDF of the Pareto distribution bounded to [lo, hi] */
+		u = WorkloadRandom(w);
+		x = c->lo / pow(1 - u * (1 - pow((double) c->lo / c->hi, c->p)), 1 / c->p);
+		return x < c->hi ? (nstime_t) x : c->hi;
+	default:
+		return c->lo;
+	}
+}
+
+// Draws the execution time of the next job and runs it. Returns the drawn time (ns)
+nstime_t WorkloadExec(struct workload *w)
+{
+	nstime_t exec = WorkloadNext(w);
+
+	sink = WorkloadRun(exec);
+	return exec;
+}
+
+// Longest execution time of the distribution (ns)
+nstime_t WorkloadMax(const struct workload_cfg *cfg)
+{
+	return cfg->hi;
+}
+
+// Writes the configuration in the WorkloadParse syntax (us). Returns buf
+const char *WorkloadFormat(const struct workload_cfg *cfg, char *buf, int len)
+{
+	switch(cfg->dist) {
+	case WL_UNIFORM:
+		snprintf(buf, len, "uniform:%g:%g", cfg->lo / 1e3, cfg->hi / 1e3);
+		break;
+	case WL_BIMODAL:
+		snprintf(buf, len, "bimodal:%g:%g:%g", cfg->lo / 1e3, cfg->hi / 1e3, cfg->p);
+		break;
+	case WL_PARETO:
+		snprintf(buf, len, "pareto:%g:%g:%g", cfg->lo / 1e3, cfg->p, cfg->hi / 1e3);
+		break;
+	default:
+		snprintf(buf, len, "%g", cfg->lo / 1e3);
+	}
+	return buf;
+}
@@ -0,0 +1,67 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Synthetic workload: self-calibrated execution times
+ *
+ * The load is the Heavy_Work numeric integration. Instead of a number
+ * of sub-intervals tuned by hand for one machine, WorkloadCalibrate()
+ * measures the cost of one sub-interval at startup (fastest of
+ * WL_CAL_RUNS runs of WL_CAL_ITERS) and WorkloadRun() converts an
+ * execution time into sub-intervals. The integration runs with the
+ * scalar kernel, or the one chosen with WorkloadKernel() (kernels.h).
+ *
+ * Execution time of each job, drawn from a distribution (times in us,
+ * or with the suffixes ns, us, ms and s):
+ *   C                      constant
+ *   uniform:LO:HI          uniform in [LO, HI]
+ *   bimodal:LO:HI:P        HI with probability P, LO otherwise
+ *   pareto:MIN:ALPHA:MAX   heavy-tailed, Pareto of shape ALPHA bounded
+ *                          to [MIN, MAX]
+ * Each task draws from its own xorshift64* generator, so a given seed
+ * gives the same sequence of execution times on any host.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __WORKLOAD_H__
+#define __WORKLOAD_H__
+
+#include <stdint.h>
+
+#include "nstime.h"
+
+#define WL_CONST 0
+#define WL_UNIFORM 1
+#define WL_BIMODAL 2
+#define WL_PARETO 3
+
+#define WL_CAL_ITERS 100000		// Sub-intervals per calibration run
+#define WL_CAL_RUNS 10			// Calibration runs (the fastest is kept)
+
+struct workload_cfg {
+	int dist;			// WL_CONST, WL_UNIFORM, WL_BIMODAL or WL_PARETO
+	nstime_t lo;		// Constant or minimum execution time (ns)
+	nstime_t hi;		// Maximum execution time (ns)
+	double p;			// Bimodal: probability of hi. Pareto: shape
+	uint64_t seed;		// Generator seed (0: chosen by the program)
+};
+
+struct workload {
+	struct workload_cfg cfg;
+	uint64_t state;		// xorshift64* state
+};
+
+int WorkloadKernel(int k);
+double WorkloadCalibrate(void);
+long WorkloadIters(nstime_t exec);
+float WorkloadRun(nstime_t exec);
+float WorkloadSpan(float lower, float upper, long n);
+int WorkloadParse(const char *str, struct workload_cfg *cfg);
+void WorkloadInit(struct workload *w, const struct workload_cfg *cfg, uint64_t seed);
+nstime_t WorkloadNext(struct workload *w);
+nstime_t WorkloadExec(struct workload *w);
+nstime_t WorkloadMax(const struct workload_cfg *cfg);
+const char *WorkloadFormat(const struct workload_cfg *cfg, char *buf, int len);
+
+#endif
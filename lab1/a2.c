@@ -3,7 +3,8 @@
  * DETI/UA/IT - Real-Time Operating Systems course
  *
  * Base code for periodic thread execution using clock_nanosleep
- * Assumes that periods and execution times are below 1 second
+ * Times are 64-bit ns (nstime.h), so periods and execution times
+ * can be of any length
  *    
  * Miguel Cabral - 93091
  * Diogo Vicente - 93262
@@ -22,32 +23,38 @@
 #include <unistd.h>
 #include <math.h>
 
+#include "../common/nstime.h" // 64-bit ns time arithmetic
+#include "../common/stats.h" // Job latency histograms
+#include "../common/trace.h" // Binary event trace
+#include "../common/release.h" // Sleep or hybrid sleep-then-spin release
+#include "../common/warmup.h" // Memory locking and dry runs before the first job
+#include "../common/workload.h" // Calibrated execution times
+
 
 /* ***********************************************
 * App specific defines
 * ***********************************************/
-#define NS_IN_SEC 1000000000L
-
 #define PERIOD_NS (100*1000*1000) 	// Period (ns component)
 #define PERIOD_S (0)				// Period (seconds component)
-
-#define BOOT_ITER 10				// Number of activations for warm-up
-                                    // There is an initial transient in which first activations
-                                    // often have an irregular behaviour (cache issues, ..)
+#define PERIOD (PERIOD_S*NS_PER_SEC + PERIOD_NS) // Period (ns)
+#define DEADLINE_NS PERIOD			// Relative deadline (implicit, equal to the period)
+#define WORK_US 20000				// Heavy_Work execution time (us), calibrated at startup
 
 
 /* ***********************************************
 * Prototypes
 * ***********************************************/
 void Heavy_Work(void);
-struct  timespec TsAdd(struct  timespec  ts1, struct  timespec  ts2);
-struct  timespec TsSub(struct  timespec  ts1, struct  timespec  ts2);
+void Dry_Work(void *arg);
 
 
 /* ***********************************************
 * Global variables
 * ***********************************************/
-uint64_t min_iat, max_iat; // Hold the minium/maximum observed inter arrival time
+struct job_stats stats; // Inter-arrival, lateness, execution and response times
+struct trace_ring trace; // Event ring of the periodic thread
+struct release release; // Release mode and wake-up statistics
+struct warmup warm; // Warm-up of the periodic thread
 
 
 /* *************************
@@ -57,9 +64,11 @@ uint64_t min_iat, max_iat; // Hold the minium/maximum observed inter arrival tim
 
 void * Thread_1_code(void *arg)
 {
-    	/* Timespec variables to manage time */
-	struct timespec ts, // thread next activation time (absolute)
+    	/* Time variables (ns) */
+	nstime_t ts, 		// thread next activation time (absolute)
+			tr, 		// scheduled release time of current job (absolute)
 			ta, 		// activation time of current thread activation (absolute)
+			tf, 		// finish time of current job (absolute)
 			tit, 		// thread inter-arrival time,
 			ta_ant, 	// activation time of last instance (absolute),
 			tp; 		// Thread period
@@ -67,21 +76,24 @@ void * Thread_1_code(void *arg)
 
 	/* Other variables */
 	int niter = 0; 	// Activation counter
-	int update; 	// Flag to signal that min/max should be updated
 	
+	/* Warm-up: prefault the stack and run the job dry until its execution time is stable */
+	WarmupThread(&warm);
+	WarmupWork(&warm, Dry_Work, NULL, WARMUP_MAX_RUNS);
+	WarmupPrint(&warm, (char *) arg);
+
 	/* Set absolute activation time of first instance */
-	tp.tv_nsec = PERIOD_NS;
-	tp.tv_sec = PERIOD_S;	
-	clock_gettime(CLOCK_MONOTONIC, &ts);
-	ts = TsAdd(ts,tp);	
+	tp = PERIOD;
+	ts = NsAdd(NsNow(CLOCK_MONOTONIC), tp);
 	
 	/* Periodic jobs ...*/ 
 	while(1) {
 
 		/* Wait until next cycle */
-		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,&ts,NULL);
-		clock_gettime(CLOCK_MONOTONIC, &ta);		
-		ts = TsAdd(ts,tp);		
+		ReleaseWait(&release, ts);
+		ta = NsNow(CLOCK_MONOTONIC);
+		tr = ts;
+		ts = NsAdd(ts, tp);
 		
 		niter++; // Coount number of activations
 		
@@ -89,34 +101,20 @@ void * Thread_1_code(void *arg)
 		if( niter == 1) 
 		    ta_ant = ta; // Init ta_ant at first activation
 	    	
-	    	tit=TsSub(ta,ta_ant);  // Compute time since last activation
+	    	tit = NsSubSat(ta, ta_ant);  // Compute time since last activation
+		TraceEmit(&trace, ta, TRACE_RELEASE, tit);
 		
-		if( niter == BOOT_ITER) {	// Boot time finsihed. Init max/min variables	    
-		      min_iat = tit.tv_nsec;
-		      max_iat = tit.tv_nsec;
-		      update = 1;
-		}else
-		if( niter > BOOT_ITER){ 	// Update max/min, if boot time elapsed 	    
-		    if(tit.tv_nsec < min_iat) {
-		      min_iat = tit.tv_nsec;
-		      update = 1;
-		    }
-		    if(tit.tv_nsec > max_iat) {
-		      max_iat = tit.tv_nsec;
-		      update = 1;
-		    }
-		}
+		if( niter > 1) 	// Record inter-arrival time, from the second activation on
+		    HistRecord(&stats.iat, tit);
 		ta_ant = ta; // Update ta_ant
-
-		  
-  		/* Print maximum/minimum inter-arrival time */
-		if(update) {
-		  printf("Task %s inter-arrival time: min: %lu / max: %lu\n\r",(char *) arg, min_iat, max_iat);
-		  update = 0;
-		}
 		
 		/* Do the actual processing */
 		Heavy_Work();		
+
+		/* Lateness, execution and response time of the job */
+		tf = NsNow(CLOCK_MONOTONIC);
+		TraceEmit(&trace, tf, TRACE_JOB_END, NsSubSat(tf, ta));
+		StatsJob(&stats, tr, ta, tf);
 	}  
   
     return NULL;
@@ -133,11 +131,15 @@ int main(int argc, char *argv[])
 	struct sched_param parm; 
 	pthread_attr_t attr;
 	char procname[40]; 
+	char tracename[64];
+	sigset_t sigset;
+	int sig;
+	struct release_cfg relcfg;
 
 
 	/* Process input args */
-	if(argc != 3) {
-	  printf("Usage: %s PROCNAME PRIORITY, where PROCNAME is a string and PRIORITY is a integer\n\r", argv[0]);
+	if(argc < 3 || argc > 4) {
+	  printf("Usage: %s PROCNAME PRIORITY [RELEASE], where PROCNAME is a string, PRIORITY is a integer and RELEASE is sleep (default), hybrid[:GUARD_US], timer or timerfd\n\r", argv[0]);
 	  return -1; 
 	}
 	/*Passing priorities via command line, as an argument - A2 */
@@ -150,23 +152,54 @@ int main(int argc, char *argv[])
 	parm.sched_priority = prty;  					
 	strcpy(procname, argv[1]);
 
+	/* Release mode - sleep, sleep-then-spin or timer back-end */
+	relcfg.mode = REL_SLEEP;
+	relcfg.guard = 0;
+	if(argc == 4 && ReleaseParse(argv[3], &relcfg)) {
+		printf("Invalid release mode %s, must be sleep, hybrid[:GUARD_US], timer or timerfd\n\r", argv[3]);
+		return -1;
+	}
+	ReleaseInit(&release, &relcfg);
+
+	/* Lock memory and prefault the heap, so the first job already runs warm */
+	WarmupProcess();
+	printf("Workload calibration: %.3f ns per sub-interval\n\r", WorkloadCalibrate());
+
 	/* Create a fixed real-time priority - A1 */
 	pthread_attr_init(&attr);
 	pthread_attr_setinheritsched(&attr,PTHREAD_EXPLICIT_SCHED);
 	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
 	pthread_attr_setschedparam(&attr, &parm); 
 	
+	/* Block report/termination signals. The periodic thread inherits the mask, so only main() gets them */
+	sigemptyset(&sigset);
+	sigaddset(&sigset, SIGUSR1);
+	sigaddset(&sigset, SIGINT);
+	sigaddset(&sigset, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+	StatsInit(&stats, DEADLINE_NS);
+
+	/* Activations are logged to a binary trace, written by a non real-time drainer thread */
+	snprintf(tracename, sizeof(tracename), "%s.trace", procname);
+	TraceInit(&trace, 1);
+	if(TraceStart(tracename))
+		return -1;
+
 	/* Create periodic thread/task */
 	err=pthread_create(&threadid, &attr, Thread_1_code, &procname);
  	if(err != 0) {
 		printf("\n\r Error creating Thread [%s]", strerror(err));
 		return -1;
 	}
-	else 
-		while(1); // Ok. Thread shall run
-	
-	/* Last thing that main() should do */
-    	pthread_exit(NULL);
+
+	/* Ok. Thread shall run. Print the statistics on demand (SIGUSR1) and at termination (CTRL+C) */
+	printf("Send SIGUSR1 (kill -USR1 %d) to print the job statistics\n\r", getpid());
+	do {
+		sigwait(&sigset, &sig);
+		StatsPrint(&stats, procname);
+		ReleasePrint(&release, procname);
+	} while(sig == SIGUSR1);
+	TraceStop();
 		
 	return 0;
 }
@@ -175,90 +208,34 @@ int main(int argc, char *argv[])
 * Auxiliary functions 
 * ************************************************/
 
-// Task load. In the case integrates numerically a function
-#define f(x) 1/(1+pow(x,2)) /* Define function to integrate*/
+// Task load. In the case integrates numerically a function, for WORK_US
 void Heavy_Work(void)
 {
-	float lower, upper, integration=0.0, stepSize, k;
-	int i, subInterval;
+	float integration;
 	
-	struct timespec ts, // Function start time
+	nstime_t ts, 		// Function start time
 			tf; 		// Function finish time
 	static int first = 0;	// Flag to signal first execution
 	
 	/* Get start time */
-	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ts = NsNow(CLOCK_MONOTONIC);
 	
-	/* Integration parameters */
-	/* These values can be tunned to cause a desired load*/
-	lower=0;
-	upper=100;
-	subInterval= 480000;       //1000000;    
-
-	 /* Calculation */
-	 /* Finding step size */
-	 stepSize = (upper - lower)/subInterval;
-
-	 /* Finding Integration Value */
-	 integration = f(lower) + f(upper);
-	 for(i=1; i<= subInterval-1; i++)
-	 {
-		k = lower + i*stepSize;
-		integration = integration + 2 * f(k);
- 	}
-	integration = integration * stepSize/2;
+	/* Calibrated load (see workload.h) */
+	integration = WorkloadRun(WORK_US * NS_PER_US);
  	
  	/* Get finish time and show results */
  	if (!first) {
-		clock_gettime(CLOCK_MONOTONIC, &tf);
-		tf=TsSub(tf,ts);  // Compute time difference form start to finish
+		tf = NsSubSat(NsNow(CLOCK_MONOTONIC), ts);  // Compute time difference form start to finish
  	
-		printf("Integration value is: %.3f. It took %9lu ns to compute.\n", integration, tf.tv_nsec);
+		printf("Integration value is: %.3f. It took %9ld ns to compute.\n", integration, tf);
 		
 		first = 1;
 	}
 
 }
 
-
-// Adds two timespect variables
-struct  timespec  TsAdd(struct  timespec  ts1, struct  timespec  ts2){
-	
-    struct  timespec  tr;
-	
-	// Add the two timespec variables
-    	tr.tv_sec = ts1.tv_sec + ts2.tv_sec ;
-    	tr.tv_nsec = ts1.tv_nsec + ts2.tv_nsec ;
-	// Check for nsec overflow	
-	if (tr.tv_nsec >= NS_IN_SEC) {
-        	tr.tv_sec++ ;
-		tr.tv_nsec = tr.tv_nsec - NS_IN_SEC ;
-    	}
-
-    return (tr) ;
-}
-
-// Subtracts two timespect variables
-struct  timespec  TsSub (struct  timespec  ts1, struct  timespec  ts2) {
-  struct  timespec  tr;
-
-  // Subtract second arg from first one 
-  if ((ts1.tv_sec < ts2.tv_sec) || ((ts1.tv_sec == ts2.tv_sec) && (ts1.tv_nsec <= ts2.tv_nsec))) {
-    // Result would be negative. Return 0
-    tr.tv_sec = tr.tv_nsec = 0 ;  
-  } else {						
-	// If T1 > T2, proceed 
-        tr.tv_sec = ts1.tv_sec - ts2.tv_sec ;
-        if (ts1.tv_nsec < ts2.tv_nsec) {
-            tr.tv_nsec = ts1.tv_nsec + NS_IN_SEC - ts2.tv_nsec ;
-            tr.tv_sec-- ;				
-        } else {
-            tr.tv_nsec = ts1.tv_nsec - ts2.tv_nsec ;
-        }
-    }
-
-    return (tr) ;
-
+// Heavy_Work with the signature of a warm-up job
+void Dry_Work(void *arg)
+{
+	Heavy_Work();
 }
-
-
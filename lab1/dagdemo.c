@@ -0,0 +1,137 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Task graph demo: acquisition -> processing -> output chain
+ *
+ * The lab3 chain (vAcqTask -> vProcTask -> vOutTask) as a DAG (see
+ * dag.h) on the host:
+ *  - acq: time-triggered, period ACQ_PERIOD_MS, samples a synthetic
+ *    sensor (a ramp)
+ *  - proc: event-triggered, averages the last PROC_SAMPLES samples and
+ *    sends the average every PROC_SAMPLES samples
+ *  - out: event-triggered (et, default) or time-triggered with period
+ *    ACQ_PERIOD_MS (tt), prints nothing, is the sink
+ * Each node runs a synthetic load (workload.h). Reports the execution
+ * time of each node, the end-to-end latency and data age at the sink
+ * and the messages lost on each edge. The data age is the one of the
+ * oldest averaged sample, (PROC_SAMPLES-1) periods before the newest.
+ * With tt the output samples the last average, which adds up to
+ * PROC_SAMPLES periods more.
+ *
+ * Usage: dagdemo [et|tt] [RELEASE]
+ *   RELEASE: release mode of the time-triggered nodes (see release.h, default sleep)
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "../common/dag.h" // Task graph runtime
+
+
+/* ***********************************************
+* App specific defines
+* ***********************************************/
+#define ACQ_PERIOD_MS 10
+#define PROC_SAMPLES 5		// Samples averaged by proc, as in vProcTask
+#define ACQ_PRIO 50
+#define PROC_PRIO 49
+#define OUT_PRIO 48
+
+
+/* ***********************************************
+* Node jobs
+* ***********************************************/
+
+// Synthetic sensor: a ramp from 0 to 1023, like the 10 bit ADC of lab3
+int Acq_job(const float *in, int nin, float *out, void *arg)
+{
+	static int x;
+
+	*out = x;
+	x = (x + 1) % 1024;
+	return 1;
+}
+
+// Average of the last PROC_SAMPLES samples, sent every PROC_SAMPLES samples
+int Proc_job(const float *in, int nin, float *out, void *arg)
+{
+	static float sum;
+	static int n;
+
+	sum += in[0];
+	if(++n < PROC_SAMPLES)
+		return 0;
+	*out = sum / PROC_SAMPLES;
+	sum = 0;
+	n = 0;
+	return 1;
+}
+
+
+/* *************************
+* main()
+* **************************/
+
+int main(int argc, char *argv[])
+{
+	static struct dag g;	// Large, nothing on the stack of main
+	struct release_cfg relcfg;
+	struct workload_cfg acq_load = {WL_UNIFORM, 800000, 1200000, 0, 0};	// ~1 ms
+	struct workload_cfg proc_load = {WL_CONST, 2000000, 2000000, 0, 0};	// 2 ms
+	struct workload_cfg out_load = {WL_CONST, 500000, 500000, 0, 0};		// 0.5 ms
+	sigset_t sigset;
+	int acq, proc, out, tt = 0, sig;
+
+	/* Process input args */
+	if(argc > 3 || (argc >= 2 && strcmp(argv[1], "et") && strcmp(argv[1], "tt"))) {
+		printf("Usage: %s [et|tt] [RELEASE], where et/tt makes the output node event or time-triggered and "
+			"RELEASE is sleep (default), hybrid[:GUARD_US], timer or timerfd\n\r", argv[0]);
+		return -1;
+	}
+	tt = argc >= 2 && !strcmp(argv[1], "tt");
+	relcfg.mode = REL_SLEEP;
+	relcfg.guard = 0;
+	if(argc == 3 && ReleaseParse(argv[2], &relcfg)) {
+		printf("Invalid release mode %s, must be sleep, hybrid[:GUARD_US], timer or timerfd\n\r", argv[2]);
+		return -1;
+	}
+
+	/* Lock memory and prefault the heap before running anything */
+	WarmupProcess();
+	printf("Workload calibration: %.3f ns per sub-interval\n\r", WorkloadCalibrate());
+
+	/* Build the graph */
+	DagInit(&g, &relcfg);
+	acq = DagAddNode(&g, "acq", Acq_job, NULL, &acq_load, ACQ_PRIO, -1, ACQ_PERIOD_MS * NS_PER_MS, 0);
+	proc = DagAddNode(&g, "proc", Proc_job, NULL, &proc_load, PROC_PRIO, -1, 0, 0);
+	out = DagAddNode(&g, "out", NULL, NULL, &out_load, OUT_PRIO, -1, tt ? ACQ_PERIOD_MS * NS_PER_MS : 0, 0);
+	DagAddEdge(&g, acq, proc);
+	DagAddEdge(&g, proc, out);
+
+	/* Block report/termination signals. The nodes inherit the mask, so only main() gets them */
+	sigemptyset(&sigset);
+	sigaddset(&sigset, SIGUSR1);
+	sigaddset(&sigset, SIGINT);
+	sigaddset(&sigset, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+	if(DagStart(&g))
+		return -1;
+
+	/* Ok. Threads shall run. Print the statistics on demand (SIGUSR1) and at termination (CTRL+C) */
+	printf("acq -> proc -> out (%s), release %s. Send SIGUSR1 (kill -USR1 %d) to print the statistics\n\r",
+		tt ? "time-triggered" : "event-triggered", ReleaseName(&relcfg), getpid());
+	do {
+		sigwait(&sigset, &sig);
+		DagPrint(&g);
+	} while(sig == SIGUSR1);
+
+	return 0;
+}
@@ -0,0 +1,244 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Check of the streaming filters (see filter.h) against references
+ *
+ * Each filter runs over SAMPLES samples of three input patterns: wide
+ * random values, narrow random values (many repeated samples, which
+ * exercises the ties of the median heaps) and a sawtooth. Its outputs
+ * are compared, sample by sample, with a reference:
+ *  - moving average and median: brute force over a copy of the window
+ *    (sum, insertion sort), for every window of 1 to FC_MAX_LEN
+ *    samples. Must match exactly
+ *  - EMA: the same recursion in double precision, for a few alphas.
+ *    Accepted within 1 (the Q(FILTER_EMA_FRAC) state rounds each step)
+ *  - biquad: the same filter in double precision with the quantized
+ *    coefficients, for a low-pass and a high-pass. The output is
+ *    rounded before it is fed back, so it is accepted within half the
+ *    gain of 1/A(z) (sum of |h| of its impulse response) plus 1
+ * Reports the mismatches and the largest difference of each filter.
+ *
+ * Usage: filtcheck [SAMPLES]    (default 2000)
+ * Exits with 1 if some filter does not match its reference.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "../common/filter.h" // Streaming filters
+
+
+/* ***********************************************
+* App specific defines
+* ***********************************************/
+#define FC_SAMPLES 2000			// Default samples per input pattern
+#define FC_MAX_LEN 64			// Windows checked: 1..FC_MAX_LEN
+#define FC_PATTERNS 3
+#define FC_WIDE 1000000			// Wide random values in [-FC_WIDE, FC_WIDE]
+#define FC_NARROW 8				// Narrow random values in [0, FC_NARROW)
+#define FC_SAW 1024				// Sawtooth period, like the 10 bit ADC of lab3
+#define FC_IMPULSE 10000		// Terms of the impulse response of 1/A(z)
+
+
+/* ***********************************************
+* Inputs and results
+* ***********************************************/
+struct result {
+	const char *name;
+	long checks;			// Outputs compared
+	long errors;			// Outside the tolerance
+	double maxdiff;			// Largest difference
+};
+
+static uint64_t rng = 88172645463325252ULL;
+
+// xorshift64
+static uint64_t Random(void)
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 7;
+	rng ^= rng << 17;
+	return rng;
+}
+
+// Sample i of input pattern p
+static int32_t Input(int p, long i)
+{
+	switch(p) {
+	case 0:
+		return (int32_t) (Random() % (2 * FC_WIDE + 1)) - FC_WIDE;
+	case 1:
+		return Random() % FC_NARROW;
+	default:
+		return i % FC_SAW;
+	}
+}
+
+// Records one comparison
+static void Compare(struct result *r, double out, double ref, double tol)
+{
+	double diff = fabs(out - ref);
+
+	r->checks++;
+	if(diff > tol)
+		r->errors++;
+	if(diff > r->maxdiff)
+		r->maxdiff = diff;
+}
+
+// n / d rounded to the nearest, as filter.c
+static int64_t RefDivRound(int64_t n, int64_t d)
+{
+	return n >= 0 ? (n + d / 2) / d : (n - d / 2) / d;
+}
+
+
+/* ***********************************************
+* Checks
+* ***********************************************/
+
+// Moving average and median against the brute force window
+void Check_window(struct result *ma_r, struct result *med_r, long samples)
+{
+	int32_t buf[FC_MAX_LEN], win[FC_MAX_LEN], sorted[FC_MAX_LEN], x, v;
+	struct filter_median_slot slots[FC_MAX_LEN];
+	struct filter_ma ma;
+	struct filter_median med;
+	int64_t sum;
+	long i;
+	int len, p, n, k, j;
+
+	for(len = 1; len <= FC_MAX_LEN; len++) {
+		for(p = 0; p < FC_PATTERNS; p++) {
+			FilterMaInit(&ma, buf, len);
+			FilterMedianInit(&med, slots, len);
+			for(i = 0; i < samples; i++) {
+				x = Input(p, i);
+				win[i % len] = x;
+				n = i + 1 < len ? i + 1 : len;
+
+				for(k = 0, sum = 0; k < n; k++)
+					sum += win[k];
+				Compare(ma_r, FilterMa(&ma, x), RefDivRound(sum, n), 0);
+
+				for(k = 0; k < n; k++) {
+					v = win[k];
+					for(j = k; j > 0 && sorted[j - 1] > v; j--)
+						sorted[j] = sorted[j - 1];
+					sorted[j] = v;
+				}
+				Compare(med_r, FilterMedian(&med, x),
+					n & 1 ? sorted[n / 2] : RefDivRound((int64_t) sorted[n / 2 - 1] + sorted[n / 2], 2), 0);
+			}
+		}
+	}
+}
+
+// EMA against the double precision recursion
+void Check_ema(struct result *r, long samples)
+{
+	const double alphas[] = { 1.0, 0.5, 0.1, 0.01 };
+	struct filter_ema ema;
+	double y = 0, a;
+	int32_t x;
+	long i;
+	int k, p;
+
+	for(k = 0; k < (int) (sizeof(alphas) / sizeof(alphas[0])); k++) {
+		for(p = 0; p < FC_PATTERNS; p++) {
+			FilterEmaInit(&ema, FILTER_Q15(alphas[k]));
+			a = FILTER_Q15(alphas[k]) / 32768.0;
+			for(i = 0; i < samples; i++) {
+				x = Input(p, i);
+				y = i == 0 ? x : y + a * (x - y);
+				Compare(r, FilterEma(&ema, x), y, 1);
+			}
+		}
+	}
+}
+
+// Biquad against the double precision filter with the same (quantized) coefficients
+void Check_biquad(struct result *r, long samples)
+{
+	const double coef[][5] = {		// b0, b1, b2, a1, a2: Butterworth, fc = fs/10
+		{ 0.0674553, 0.1349105, 0.0674553, -1.1429805, 0.4128016 },		// Low-pass
+		{ 0.6389455, -1.2778910, 0.6389455, -1.1429805, 0.4128016 },	// High-pass
+	};
+	struct filter_biquad f;
+	double b0, b1, b2, a1, a2, x1, x2, y, y1, y2, gain, tol;
+	int32_t x;
+	long i;
+	int k, p;
+
+	for(k = 0; k < (int) (sizeof(coef) / sizeof(coef[0])); k++) {
+		b0 = FILTER_Q14(coef[k][0]) / 16384.0;
+		b1 = FILTER_Q14(coef[k][1]) / 16384.0;
+		b2 = FILTER_Q14(coef[k][2]) / 16384.0;
+		a1 = FILTER_Q14(coef[k][3]) / 16384.0;
+		a2 = FILTER_Q14(coef[k][4]) / 16384.0;
+
+		/* Rounding of the fed back output: up to 1/2 per step through 1/A(z) */
+		gain = 0;
+		for(i = 0, y1 = y2 = 0; i < FC_IMPULSE; i++) {
+			y = (i == 0) - a1 * y1 - a2 * y2;
+			gain += fabs(y);
+			y2 = y1;
+			y1 = y;
+		}
+		tol = gain / 2 + 1;
+
+		for(p = 0; p < FC_PATTERNS; p++) {
+			FilterBiquadInit(&f, FILTER_Q14(coef[k][0]), FILTER_Q14(coef[k][1]), FILTER_Q14(coef[k][2]),
+				FILTER_Q14(coef[k][3]), FILTER_Q14(coef[k][4]));
+			x1 = x2 = y1 = y2 = 0;
+			for(i = 0; i < samples; i++) {
+				x = Input(p, i);
+				y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+				x2 = x1;
+				x1 = x;
+				y2 = y1;
+				y1 = y;
+				Compare(r, FilterBiquad(&f, x), y, tol);
+			}
+		}
+	}
+}
+
+
+/* *************************
+* main()
+* **************************/
+
+int main(int argc, char *argv[])
+{
+	struct result r[4] = { {"average"}, {"median"}, {"ema"}, {"biquad"} };
+	long samples = FC_SAMPLES;
+	int i, failed = 0;
+
+	/* Process input args */
+	if(argc > 2) {
+		printf("Usage: %s [SAMPLES], the samples per input pattern\n\r", argv[0]);
+		return -1;
+	}
+	if(argc == 2 && (samples = atol(argv[1])) < 1) {
+		printf("Invalid number of samples %s\n\r", argv[1]);
+		return -1;
+	}
+
+	Check_window(&r[0], &r[1], samples);
+	Check_ema(&r[2], samples);
+	Check_biquad(&r[3], samples);
+
+	printf("%-8s %10s %10s %12s\n\r", "Filter", "Checks", "Errors", "Max diff");
+	for(i = 0; i < 4; i++) {
+		printf("%-8s %10ld %10ld %12.3f %s\n\r", r[i].name, r[i].checks, r[i].errors, r[i].maxdiff,
+			r[i].errors ? "MISMATCH" : "ok");
+		failed |= r[i].errors != 0;
+	}
+	return failed;
+}
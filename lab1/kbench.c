@@ -0,0 +1,138 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Benchmark of the Heavy_Work integration kernels (see kernels.h)
+ *
+ * Checks every kernel supported by the CPU (see KernVerify()) and
+ * then times RUNS integrations of POINTS sub-intervals with each, after
+ * a warm-up (see warmup.h). The benchmark runs pinned to the current
+ * core, with SCHED_FIFO priority KB_PRIO when allowed. For each kernel
+ * it reports the execution time (mean, standard deviation, minimum,
+ * p99 and maximum) and the speedup of the mean and of the maximum
+ * (the WCET) over the mul kernel, the vector arithmetic one lane at a
+ * time (the scalar one also pays for pow).
+ *
+ * Usage: kbench [POINTS] [RUNS]    (default 1000000 and 200)
+ * Exits with 1 if some kernel fails the check of KernVerify().
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <math.h>
+
+#include "../common/nstime.h" // 64-bit ns time arithmetic
+#include "../common/hist.h" // Execution time histograms
+#include "../common/warmup.h" // Memory locking and dry runs
+#include "../common/kernels.h" // Scalar and SIMD integration kernels
+
+
+/* ***********************************************
+* App specific defines
+* ***********************************************/
+#define KB_POINTS 1000000		// Default sub-intervals per run
+#define KB_RUNS 200				// Default timed runs per kernel
+#define KB_PRIO 50				// SCHED_FIFO priority, if allowed
+
+
+/* ***********************************************
+* Benchmark of one kernel
+* ***********************************************/
+struct bench {
+	kern_fn fn;
+	long points;
+	struct hist exec;		// Execution time (ns)
+	double sum, sum2;		// For the mean and standard deviation
+};
+
+volatile float result;		// Keeps the compiler from removing the runs
+
+// One run, with the signature of a warm-up job
+void Bench_run(void *arg)
+{
+	struct bench *b = (struct bench *) arg;
+
+	result = b->fn(KERN_LOWER, KERN_UPPER, b->points);
+}
+
+/* *************************
+* main()
+* **************************/
+
+int main(int argc, char *argv[])
+{
+	struct bench b[KERN_COUNT];
+	struct warmup warm;
+	struct sched_param parm;
+	cpu_set_t cpuset;
+	long points = KB_POINTS;
+	int runs = KB_RUNS, k, i;
+	nstime_t t0, c;
+	double mean, sd;
+
+	/* Process input args */
+	if(argc > 3) {
+		printf("Usage: %s [POINTS] [RUNS], the sub-intervals per integration and the timed runs per kernel\n\r", argv[0]);
+		return -1;
+	}
+	if(argc >= 2 && (points = atol(argv[1])) < 2) {
+		printf("Invalid number of points %s\n\r", argv[1]);
+		return -1;
+	}
+	if(argc == 3 && (runs = atoi(argv[2])) < 1) {
+		printf("Invalid number of runs %s\n\r", argv[2]);
+		return -1;
+	}
+
+	/* Same core and, if allowed, no preemption by normal tasks */
+	CPU_ZERO(&cpuset);
+	CPU_SET(sched_getcpu(), &cpuset);
+	sched_setaffinity(0, sizeof(cpuset), &cpuset);
+	parm.sched_priority = KB_PRIO;
+	if(sched_setscheduler(0, SCHED_FIFO, &parm))
+		printf("SCHED_FIFO not allowed [%s], running as a normal task\n\r", strerror(errno));
+	WarmupProcess();
+
+	if(KernVerify(points))
+		return 1;
+
+	for(k = 0; k < KERN_COUNT; k++) {
+		if(!KernSupported(k))
+			continue;
+		memset(&b[k], 0, sizeof(b[k]));
+		b[k].fn = KernGet(k);
+		b[k].points = points;
+		HistInit(&b[k].exec);
+
+		WarmupThread(&warm);
+		WarmupWork(&warm, Bench_run, &b[k], WARMUP_MAX_RUNS);
+		for(i = 0; i < runs; i++) {
+			t0 = NsNow(CLOCK_MONOTONIC);
+			Bench_run(&b[k]);
+			c = NsSubSat(NsNow(CLOCK_MONOTONIC), t0);
+			HistRecord(&b[k].exec, c);
+			b[k].sum += c;
+			b[k].sum2 += (double) c * c;
+		}
+	}
+
+	/* After all the runs: the speedups need the mul kernel */
+	printf("%-8s %5s %12s %10s %12s %12s %12s %8s %8s\n\r", "Kernel", "Lanes", "Mean (ns)", "SD (ns)", "Min (ns)",
+		"p99 (ns)", "Max (ns)", "Speedup", "WCET");
+	for(k = 0; k < KERN_COUNT; k++) {
+		if(!KernSupported(k))
+			continue;
+		mean = b[k].sum / runs;
+		sd = sqrt(fmax(b[k].sum2 / runs - mean * mean, 0));
+		printf("%-8s %5d %12.0f %10.0f %12lu %12lu %12lu %7.2fx %7.2fx\n\r", KernName(k), KernLanes(k), mean, sd,
+			b[k].exec.min, HistPercentile(&b[k].exec, 99), b[k].exec.max, b[KERN_MUL].sum / b[k].sum,
+			(double) b[KERN_MUL].exec.max / b[k].exec.max);
+	}
+	return 0;
+}
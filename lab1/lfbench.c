@@ -0,0 +1,389 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Benchmark of the lock-free primitives (see lockfree.h) against the
+ * semaphore versions
+ *
+ * Cost: RUNS batches of OPS operations of each primitive and of the
+ * same operation protected by a POSIX semaphore (like the rt_sem of
+ * lab2/a3 and the FreeRTOS semaphores of lab3), uncontended, pinned to
+ * the current core with SCHED_FIFO priority LB_PRIO when allowed. One
+ * operation is
+ *  - counter: one increment
+ *  - seqlock: write and read back LB_WORDS words
+ *  - triple buffer: publish and read one LB_WORDS words value
+ *  - ring: push and pop one LB_WORDS words element
+ * Reports the best and mean cost per operation and the speedup.
+ *
+ * Stress: a writer and a reader thread run concurrently for LB_STRESS_MS
+ * on each primitive. The writer puts the same sequence number in every
+ * word of a value, so the reader detects torn (mixed) values; ring
+ * elements must also arrive in order and the counter must not lose
+ * increments.
+ *
+ * Usage: lfbench [OPS] [RUNS]    (default 100000 and 50)
+ * Exits with 1 if the stress test finds an inconsistent value.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "../common/nstime.h" // 64-bit ns time arithmetic
+#include "../common/warmup.h" // Memory locking
+#include "../common/lockfree.h" // Lock-free primitives
+
+
+/* ***********************************************
+* App specific defines
+* ***********************************************/
+#define LB_OPS 100000			// Default operations per batch
+#define LB_RUNS 50				// Default timed batches per benchmark
+#define LB_PRIO 50				// SCHED_FIFO priority, if allowed
+#define LB_WORDS 4				// Words of the shared state
+#define LB_RING 64				// Ring slots
+#define LB_STRESS_MS 300		// Duration of each stress test
+#define LB_COUNTER_OPS 1000000	// Increments per thread of the counter stress test
+
+
+/* ***********************************************
+* Shared state
+* ***********************************************/
+struct value {
+	uint32_t w[LB_WORDS];
+};
+
+sem_t sem;					// Semaphore versions
+struct lf_counter counter;
+uint32_t sem_counter;
+struct lf_seqlock seqlock;
+struct value state, copy;
+struct lf_triple triple;
+struct value tbuf[3];
+struct lf_ring ring;
+struct value rbuf[LB_RING];
+struct value squeue[LB_RING];
+uint32_t shead, stail;
+volatile int stop;
+
+
+/* ***********************************************
+* One operation of each benchmark
+* ***********************************************/
+void Counter_lf(void)
+{
+	LfCounterNext(&counter);
+}
+
+void Counter_sem(void)
+{
+	sem_wait(&sem);
+	sem_counter++;
+	sem_post(&sem);
+}
+
+void State_lf(void)
+{
+	struct value v = copy;
+
+	LfSeqWrite(&seqlock, &state, &v, sizeof(v));
+	LfSeqRead(&seqlock, &copy, &state, sizeof(copy));
+}
+
+void State_sem(void)
+{
+	struct value v = copy;
+
+	sem_wait(&sem);
+	state = v;
+	sem_post(&sem);
+	sem_wait(&sem);
+	copy = state;
+	sem_post(&sem);
+}
+
+void Triple_lf(void)
+{
+	tbuf[LfTripleBack(&triple)] = copy;
+	LfTriplePublish(&triple);
+	copy = tbuf[LfTripleRead(&triple, NULL)];
+}
+
+void Queue_lf(void)
+{
+	LfRingPush(&ring, &copy);
+	LfRingPop(&ring, &copy);
+}
+
+void Queue_sem(void)
+{
+	sem_wait(&sem);
+	squeue[shead++ % LB_RING] = copy;
+	sem_post(&sem);
+	sem_wait(&sem);
+	copy = squeue[stail++ % LB_RING];
+	sem_post(&sem);
+}
+
+// Best and mean cost per operation (ns) of runs batches of ops operations
+void Bench(void (*op)(void), long ops, int runs, double *best, double *mean)
+{
+	nstime_t t0, c, sum = 0, min = NSTIME_MAX;
+	long k;
+	int i;
+
+	for(k = 0; k < ops; k++)	// Warm-up batch
+		op();
+	for(i = 0; i < runs; i++) {
+		t0 = NsNow(CLOCK_MONOTONIC);
+		for(k = 0; k < ops; k++)
+			op();
+		c = NsSubSat(NsNow(CLOCK_MONOTONIC), t0);
+		sum += c;
+		if(c < min)
+			min = c;
+	}
+	*best = (double) min / ops;
+	*mean = (double) sum / ops / runs;
+}
+
+
+/* ***********************************************
+* Stress tests: writer and reader threads
+* ***********************************************/
+struct stress {
+	const char *name;
+	void *(*writer)(void *);
+	void *(*reader)(void *);
+	uint64_t writes, reads, retries, errors;
+};
+
+// Value with every word equal to seq
+static void Fill(struct value *v, uint32_t seq)
+{
+	int i;
+
+	for(i = 0; i < LB_WORDS; i++)
+		v->w[i] = seq;
+}
+
+// 1 if the words of v differ (torn value)
+static int Torn(const struct value *v)
+{
+	int i;
+
+	for(i = 1; i < LB_WORDS; i++)
+		if(v->w[i] != v->w[0])
+			return 1;
+	return 0;
+}
+
+void *Counter_writer(void *arg)
+{
+	long k;
+
+	for(k = 0; k < LB_COUNTER_OPS; k++)
+		LfCounterNext(&counter);
+	return NULL;
+}
+
+void *Counter_reader(void *arg)
+{
+	return Counter_writer(arg);
+}
+
+void *Seq_writer(void *arg)
+{
+	struct stress *s = (struct stress *) arg;
+	struct value v;
+	uint32_t seq = 0;
+
+	while(!stop) {
+		Fill(&v, ++seq);
+		LfSeqWrite(&seqlock, &state, &v, sizeof(v));
+	}
+	s->writes = seq;
+	return NULL;
+}
+
+void *Seq_reader(void *arg)
+{
+	struct stress *s = (struct stress *) arg;
+	struct value v;
+
+	while(!stop) {
+		s->retries += LfSeqRead(&seqlock, &v, &state, sizeof(v));
+		s->errors += Torn(&v);
+		s->reads++;
+	}
+	return NULL;
+}
+
+void *Triple_writer(void *arg)
+{
+	struct stress *s = (struct stress *) arg;
+	uint32_t seq = 0;
+
+	while(!stop) {
+		Fill(&tbuf[LfTripleBack(&triple)], ++seq);
+		LfTriplePublish(&triple);
+	}
+	s->writes = seq;
+	return NULL;
+}
+
+void *Triple_reader(void *arg)
+{
+	struct stress *s = (struct stress *) arg;
+	const struct value *v;
+	uint32_t last = 0;
+	int fresh;
+
+	while(!stop) {
+		v = &tbuf[LfTripleRead(&triple, &fresh)];
+		s->errors += Torn(v) || v->w[0] < last || (fresh && v->w[0] == last);
+		last = v->w[0];
+		s->reads += fresh;
+	}
+	return NULL;
+}
+
+void *Ring_writer(void *arg)
+{
+	struct stress *s = (struct stress *) arg;
+	struct value v;
+	uint32_t seq = 1;
+
+	while(!stop) {
+		Fill(&v, seq);
+		if(LfRingPush(&ring, &v) == 0)
+			seq++;
+		else
+			s->retries++;	// Full
+	}
+	s->writes = seq - 1;
+	return NULL;
+}
+
+void *Ring_reader(void *arg)
+{
+	struct stress *s = (struct stress *) arg;
+	struct value v;
+	uint32_t next = 1;
+
+	while(1) {
+		if(LfRingPop(&ring, &v)) {
+			if(stop)
+				break;
+			continue;	// Empty
+		}
+		s->errors += Torn(&v) || v.w[0] != next;
+		next = v.w[0] + 1;
+		s->reads++;
+	}
+	return NULL;
+}
+
+// Runs the writer and the reader of s concurrently. Returns the inconsistent values found
+uint64_t Stress(struct stress *s)
+{
+	pthread_t w, r;
+	struct timespec d = {0, LB_STRESS_MS * NS_PER_MS};
+
+	stop = 0;
+	pthread_create(&w, NULL, s->writer, s);
+	pthread_create(&r, NULL, s->reader, s);
+	if(s->writer != Counter_writer) {
+		nanosleep(&d, NULL);
+		stop = 1;
+	}
+	pthread_join(w, NULL);
+	pthread_join(r, NULL);
+	return s->errors;
+}
+
+/* *************************
+* main()
+* **************************/
+
+int main(int argc, char *argv[])
+{
+	struct {
+		const char *name;
+		void (*lf)(void);
+		void (*sem)(void);
+	} b[] = {
+		{"counter", Counter_lf, Counter_sem},
+		{"seqlock", State_lf, State_sem},
+		{"triple", Triple_lf, State_sem},
+		{"ring", Queue_lf, Queue_sem},
+	};
+	struct stress s[] = {
+		{"counter", Counter_writer, Counter_reader},
+		{"seqlock", Seq_writer, Seq_reader},
+		{"triple", Triple_writer, Triple_reader},
+		{"ring", Ring_writer, Ring_reader},
+	};
+	struct sched_param parm;
+	cpu_set_t cpuset;
+	long ops = LB_OPS;
+	int runs = LB_RUNS, i, failed = 0;
+	double lf_best, lf_mean, sem_best, sem_mean;
+
+	/* Process input args */
+	if(argc > 3) {
+		printf("Usage: %s [OPS] [RUNS], the operations per batch and the timed batches per benchmark\n\r", argv[0]);
+		return -1;
+	}
+	if(argc >= 2 && (ops = atol(argv[1])) < 1) {
+		printf("Invalid number of operations %s\n\r", argv[1]);
+		return -1;
+	}
+	if(argc == 3 && (runs = atoi(argv[2])) < 1) {
+		printf("Invalid number of runs %s\n\r", argv[2]);
+		return -1;
+	}
+
+	sem_init(&sem, 0, 1);
+	LfTripleInit(&triple);
+	LfRingInit(&ring, rbuf, LB_RING, sizeof(struct value));
+
+	/* Stress tests first, with the default policy so the threads preempt each other */
+	printf("%-8s %12s %12s %12s %8s\n\r", "Stress", "Writes", "Reads", "Retries", "Errors");
+	for(i = 0; i < (int) (sizeof(s) / sizeof(s[0])); i++) {
+		Stress(&s[i]);
+		if(s[i].writer == Counter_writer) {
+			s[i].writes = LfCounterGet(&counter);
+			s[i].errors = s[i].writes != 2 * LB_COUNTER_OPS;
+		}
+		printf("%-8s %12lu %12lu %12lu %8lu\n\r", s[i].name, s[i].writes, s[i].reads, s[i].retries, s[i].errors);
+		failed |= s[i].errors != 0;
+	}
+
+	/* Same core and, if allowed, no preemption by normal tasks */
+	CPU_ZERO(&cpuset);
+	CPU_SET(sched_getcpu(), &cpuset);
+	sched_setaffinity(0, sizeof(cpuset), &cpuset);
+	parm.sched_priority = LB_PRIO;
+	if(sched_setscheduler(0, SCHED_FIFO, &parm))
+		printf("SCHED_FIFO not allowed [%s], running as a normal task\n\r", strerror(errno));
+	WarmupProcess();
+
+	printf("%-8s %14s %14s %14s %14s %8s\n\r", "Cost", "Lock-free best", "mean (ns/op)", "Semaphore best",
+		"mean (ns/op)", "Speedup");
+	for(i = 0; i < (int) (sizeof(b) / sizeof(b[0])); i++) {
+		Bench(b[i].lf, ops, runs, &lf_best, &lf_mean);
+		Bench(b[i].sem, ops, runs, &sem_best, &sem_mean);
+		printf("%-8s %14.2f %14.2f %14.2f %14.2f %7.2fx\n\r", b[i].name, lf_best, lf_mean, sem_best, sem_mean,
+			sem_mean / lf_mean);
+	}
+	return failed;
+}
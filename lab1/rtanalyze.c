@@ -0,0 +1,167 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Offline schedulability analyzer for rtexec task tables
+ *
+ * Reads a task table (see taskset.h). Each task needs its WCET, either
+ * wcet=T or, for DEADLINE tasks, runtime=T. Shared resources are given
+ * with cs=RES:T. Tasks are analyzed on the lowest core of their CPU set.
+ * Tasks with CPUS auto are first partitioned to CORES cores (default:
+ * the online cores) with the given heuristic (see partition.h).
+ * For every core prints the fixed priority response times (with the
+ * blocking terms of the chosen protocol) and the EDF processor demand
+ * test. Tasks with policy OTHER are not analyzed.
+ *
+ * Usage: rtanalyze TASKFILE [pcp|pip] [ff|wf] [CORES]
+ * Returns 0 if every task meets its deadline under its own policy
+ * (FIFO/RR: response time analysis, DEADLINE: EDF demand test).
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../common/partition.h"
+#include "taskset.h"
+
+#define NS_2_MS(ns) ((ns) / 1e6) /* Convert ns to ms */
+
+int main(int argc, char *argv[])
+{
+	struct task_param params[MAX_TASKS];
+	struct an_task tasks[MAX_TASKS];
+	int policy[MAX_TASKS];
+	int i, k, n, na = 0, core, max_core = 0, protocol = AN_PCP;
+	int heuristic = PART_WFD, ncores = sysconf(_SC_NPROCESSORS_ONLN), partition = 0;
+	int fp_misses, edf_fail, has_fp, has_edf, ok = 1;
+	uint64_t fail_L;
+
+	/* Process input args */
+	if(argc < 2 || argc > 5) {
+		printf("Usage: %s TASKFILE [pcp|pip] [ff|wf] [CORES], where TASKFILE is a task table (see taskset.h)\n\r", argv[0]);
+		return -1;
+	}
+	for(i = 2; i < argc; i++) {
+		if(!strcmp(argv[i], "pcp"))
+			protocol = AN_PCP;
+		else if(!strcmp(argv[i], "pip"))
+			protocol = AN_PIP;
+		else if(!strcmp(argv[i], "ff"))
+			heuristic = PART_FFD;
+		else if(!strcmp(argv[i], "wf"))
+			heuristic = PART_WFD;
+		else if((ncores = atoi(argv[i])) < 1) {
+			printf("Invalid option %s, must be pcp, pip, ff, wf or a number of cores\n\r", argv[i]);
+			return -1;
+		}
+	}
+
+	n = TasksetLoad(argv[1], params, MAX_TASKS);
+	if(n < 0)
+		return -1;
+
+	/* Assign a core to the CPUS auto tasks */
+	for(i = 0; i < n; i++)
+		partition |= params[i].autocpu;
+	if(partition) {
+		printf("Partitioning to %d cores (%s)\n\r", ncores, PartitionName(heuristic));
+		if(TasksetPartition(params, n, ncores, heuristic, protocol)) {
+			printf("\nTask set is NOT schedulable\n");
+			return 1;
+		}
+	}
+
+	/* Build the analysis model */
+	for(i = 0; i < n; i++) {
+		if(params[i].policy == SCHED_OTHER) {
+			printf("Task %s: policy OTHER, not analyzed\n\r", params[i].name);
+			continue;
+		}
+		memset(&tasks[na], 0, sizeof(tasks[na]));
+		strcpy(tasks[na].name, params[i].name);
+		tasks[na].C = params[i].wcet ? params[i].wcet : params[i].runtime;
+		tasks[na].T = params[i].period;
+		tasks[na].D = params[i].deadline;
+		tasks[na].J = params[i].jitter;
+		tasks[na].prio = params[i].prio;
+		tasks[na].policy = params[i].policy == SCHED_DEADLINE ? AN_EDF : AN_FP;
+		if(tasks[na].C == 0) {
+			printf("Task %s: no WCET, add a wcet=T option\n\r", params[i].name);
+			return -1;
+		}
+		if(tasks[na].D > tasks[na].T)
+			printf("Task %s: deadline above period, only the first job is analyzed\n\r", params[i].name);
+
+		for(core = 0; !CPU_ISSET(core, &params[i].cpus); core++);
+		if(CPU_COUNT(&params[i].cpus) > 1 && params[i].policy != SCHED_DEADLINE)
+			printf("Task %s: may run on %d cores, analyzed on core %d\n\r", params[i].name, CPU_COUNT(&params[i].cpus), core);
+		tasks[na].core = core;
+		if(core > max_core)
+			max_core = core;
+
+		tasks[na].ncs = params[i].ncs;
+		for(k = 0; k < params[i].ncs && k < AN_MAX_CS; k++) {
+			strcpy(tasks[na].cs[k].res, params[i].cs[k].res);
+			tasks[na].cs[k].len = params[i].cs[k].len;
+		}
+		policy[na++] = params[i].policy;
+	}
+
+	/* Analyze each core */
+	for(core = 0; core <= max_core; core++) {
+		has_fp = has_edf = 0;
+		for(i = 0; i < na; i++) {
+			if(tasks[i].core != core)
+				continue;
+			if(policy[i] == SCHED_DEADLINE)
+				has_edf = 1;
+			else
+				has_fp = 1;
+		}
+		if(!has_fp && !has_edf)
+			continue;
+
+		AnResponseTimes(tasks, na, core, protocol);
+		fp_misses = 0;
+		for(i = 0; i < na; i++)
+			if(tasks[i].core == core && policy[i] != SCHED_DEADLINE && tasks[i].R == 0)
+				fp_misses++;
+		edf_fail = AnEdfDemand(tasks, na, core, &fail_L);
+
+		printf("\nCore %d: utilization %.3f\n", core, AnUtilization(tasks, na, core));
+		printf("%-16s %10s %10s %10s %4s %10s %10s  %s\n", "Task", "C (ms)", "T (ms)", "D (ms)", "Prio", "B (ms)", "R (ms)", "Verdict");
+		for(i = 0; i < na; i++) {
+			if(tasks[i].core != core)
+				continue;
+			printf("%-16s %10.3f %10.3f %10.3f %4d %10.3f ", tasks[i].name, NS_2_MS(tasks[i].C), NS_2_MS(tasks[i].T),
+				NS_2_MS(tasks[i].D), tasks[i].prio, NS_2_MS(tasks[i].B));
+			if(policy[i] == SCHED_DEADLINE)
+				printf("%10s  EDF (see demand test)\n", "-");
+			else if(tasks[i].R)
+				printf("%10.3f  ok\n", NS_2_MS(tasks[i].R));
+			else
+				printf("%10s  DEADLINE MISS\n", "> D");
+		}
+
+		if(has_fp)
+			printf("Fixed priorities (%s): %s\n", protocol == AN_PIP ? "PIP" : "PCP",
+				fp_misses ? "NOT schedulable" : "schedulable");
+		if(edf_fail && fail_L)
+			printf("EDF demand test: NOT schedulable (demand exceeds interval L = %.3f ms)\n", NS_2_MS(fail_L));
+		else
+			printf("EDF demand test: %s\n", edf_fail ? "NOT schedulable (utilization above 1)" : "schedulable");
+
+		/* Verdict under the policy actually used by each task */
+		if((has_fp && fp_misses) || (has_edf && edf_fail))
+			ok = 0;
+	}
+
+	printf("\n%s\n", ok ? "Task set is schedulable" : "Task set is NOT schedulable");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,263 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Dispatcher executive: runs a large task set with a few threads
+ *
+ * Same task table as rtexec (see taskset.h, copies=N helps to describe
+ * thousands of tasks), but instead of one thread per task the tasks are
+ * released by WORKERS dispatcher threads per core (see dispatch.h).
+ * Each task goes to the worker with the lowest job rate among the cores
+ * of its CPU set. A worker runs with the highest priority and policy of
+ * its tasks and releases them in release order, each job to completion.
+ * DEADLINE and fork-join (par=N) tasks are not supported.
+ *
+ * Each worker runs every job of its tasks once, dry, before the start
+ * time is set (see DispWarmup), so the jobs are measured from the first.
+ *
+ * Reports the lateness and response time of each worker and the
+ * inter-arrival time of each task.
+ *
+ * Usage: rtdisp TASKFILE [WORKERS] [RELEASE]
+ *   WORKERS: dispatcher threads per core (default 1)
+ *   RELEASE: release mode of the workers (see release.h, default sleep)
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "../common/dispatch.h" // Heap based dispatcher
+#include "../common/workload.h" // Calibrated execution times
+#include "taskset.h"
+
+
+/* ***********************************************
+* App specific defines
+* ***********************************************/
+#define MAX_DISP_TASKS 16384			// Logical tasks
+#define START_DELAY_NS (100*1000*1000)	// Time between the end of the warm-up and the first release
+
+
+/* ***********************************************
+* Worker descriptor
+* ***********************************************/
+struct worker {
+	struct dispatcher d;
+	pthread_t thread;
+	int core;
+	int prio, policy;		// Highest of its tasks
+	int ntasks;
+	double rate;			// Jobs per second of its tasks
+};
+
+
+/* ***********************************************
+* Prototypes
+* ***********************************************/
+void *Worker_code(void *arg);
+void Task_job(struct disp_task *t);
+
+
+/* ***********************************************
+* Global variables
+* ***********************************************/
+pthread_barrier_t start_barrier;	// Workers warm (first wait), releases set (second wait)
+
+
+/* *************************
+* Worker thread code
+* **************************/
+
+void *Worker_code(void *arg)
+{
+	struct worker *w = (struct worker *) arg;
+
+	/* Warm-up, then wait for all the workers and for main() to set the start time */
+	DispWarmup(&w->d);
+	pthread_barrier_wait(&start_barrier);
+	pthread_barrier_wait(&start_barrier);
+
+	DispRun(&w->d);
+	return NULL;
+}
+
+// Job of a logical task
+void Task_job(struct disp_task *t)
+{
+	WorkloadExec((struct workload *) t->arg);
+}
+
+/* *************************
+* main()
+* **************************/
+
+int main(int argc, char *argv[])
+{
+	struct task_param *params;
+	struct disp_task *dtasks;
+	struct workload *works;
+	struct worker *workers;
+	struct release_cfg relcfg;
+	struct sched_param parm;
+	nstime_t start;
+	pthread_attr_t attr;
+	cpu_set_t cpuset;
+	sigset_t sigset;
+	int i, w, best, n, nw, wpc = 1, ncores, err, sig, active;
+	int *owner;
+	char label[64];
+
+	/* Process input args */
+	if(argc < 2 || argc > 4) {
+		printf("Usage: %s TASKFILE [WORKERS] [RELEASE], where TASKFILE is a task table (see taskset.h), WORKERS the "
+			"dispatcher threads per core and RELEASE is sleep (default), hybrid[:GUARD_US], timer or timerfd\n\r", argv[0]);
+		return -1;
+	}
+	if(argc >= 3 && (wpc = atoi(argv[2])) < 1) {
+		printf("Invalid number of workers %s\n\r", argv[2]);
+		return -1;
+	}
+	relcfg.mode = REL_SLEEP;
+	relcfg.guard = 0;
+	if(argc == 4 && ReleaseParse(argv[3], &relcfg)) {
+		printf("Invalid release mode %s, must be sleep, hybrid[:GUARD_US], timer or timerfd\n\r", argv[3]);
+		return -1;
+	}
+
+	params = calloc(MAX_DISP_TASKS, sizeof(struct task_param));
+	dtasks = calloc(MAX_DISP_TASKS, sizeof(struct disp_task));
+	works = calloc(MAX_DISP_TASKS, sizeof(struct workload));
+	owner = calloc(MAX_DISP_TASKS, sizeof(int));
+	if(params == NULL || dtasks == NULL || works == NULL || owner == NULL) {
+		printf("Not enough memory for %d tasks\n\r", MAX_DISP_TASKS);
+		return -1;
+	}
+	n = TasksetLoad(argv[1], params, MAX_DISP_TASKS);
+	if(n < 0)
+		return -1;
+
+	/* Lock memory and prefault the heap before running anything */
+	WarmupProcess();
+	printf("Workload calibration: %.3f ns per sub-interval\n\r", WorkloadCalibrate());
+
+	ncores = sysconf(_SC_NPROCESSORS_ONLN);
+	nw = ncores * wpc;
+	workers = calloc(nw, sizeof(struct worker));
+	if(workers == NULL) {
+		printf("Not enough memory for %d workers\n\r", nw);
+		return -1;
+	}
+	for(w = 0; w < nw; w++)
+		workers[w].core = w / wpc;
+
+	/* Assign each task to the least loaded worker of its CPU set */
+	for(i = 0; i < n; i++) {
+		if(params[i].policy == SCHED_DEADLINE) {
+			printf("Task %s: DEADLINE tasks are not supported by the dispatcher\n\r", params[i].name);
+			return -1;
+		}
+		if(params[i].par > 1) {
+			printf("Task %s: fork-join (par=) tasks are not supported by the dispatcher\n\r", params[i].name);
+			return -1;
+		}
+		best = -1;
+		for(w = 0; w < nw; w++)
+			if(CPU_ISSET(workers[w].core, &params[i].cpus) && (best < 0 || workers[w].rate < workers[best].rate))
+				best = w;
+		if(best < 0) {
+			printf("Task %s: no online core in its CPU set\n\r", params[i].name);
+			return -1;
+		}
+		owner[i] = best;
+		workers[best].ntasks++;
+		workers[best].rate += (double) NS_PER_SEC / params[i].period;
+		if(params[i].prio > workers[best].prio || workers[best].policy == SCHED_OTHER) {
+			workers[best].prio = params[i].prio;
+			workers[best].policy = params[i].policy;
+		}
+	}
+
+	/* Block report/termination signals. The workers inherit the mask, so only main() gets them */
+	sigemptyset(&sigset);
+	sigaddset(&sigset, SIGUSR1);
+	sigaddset(&sigset, SIGINT);
+	sigaddset(&sigset, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+	/* Releases relative to the start time, set by DispStart after the warm-up */
+	for(w = 0; w < nw; w++)
+		if(workers[w].ntasks && DispInit(&workers[w].d, workers[w].ntasks, Task_job, &relcfg)) {
+			printf("Not enough memory for worker %d\n\r", w);
+			return -1;
+		}
+	for(i = 0; i < n; i++) {
+		dtasks[i].period = params[i].period;
+		dtasks[i].deadline = params[i].deadline;
+		WorkloadInit(&works[i], &params[i].workload, i + 1);
+		dtasks[i].arg = &works[i];
+		DispAdd(&workers[owner[i]].d, &dtasks[i], params[i].offset);
+	}
+
+	/* Create the dispatcher threads. They warm up and wait for the start time */
+	for(w = 0, active = 0; w < nw; w++)
+		active += workers[w].ntasks > 0;
+	pthread_barrier_init(&start_barrier, NULL, active + 1);
+	start = NsNow(CLOCK_MONOTONIC);
+	for(w = 0; w < nw; w++) {
+		if(workers[w].ntasks == 0)
+			continue;
+		printf("Worker %d: CPU %d / %s prio %d / tasks: %d / %.1f jobs/s\n\r", w, workers[w].core,
+			PolicyName(workers[w].policy), workers[w].prio, workers[w].ntasks, workers[w].rate);
+
+		CPU_ZERO(&cpuset);
+		CPU_SET(workers[w].core, &cpuset);
+		parm.sched_priority = workers[w].prio;
+		pthread_attr_init(&attr);
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, workers[w].policy);
+		pthread_attr_setschedparam(&attr, &parm);
+		pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpuset);
+
+		err = pthread_create(&workers[w].thread, &attr, Worker_code, &workers[w]);
+		pthread_attr_destroy(&attr);
+		if(err != 0) {
+			printf("\n\r Error creating worker %d [%s]\n\r", w, strerror(err));
+			return -1;
+		}
+	}
+
+	/* All the offsets are relative to the same start time, set once every worker is warm */
+	pthread_barrier_wait(&start_barrier);
+	printf("Warm-up of %d workers: %.3f ms\n\r", active, NsSubSat(NsNow(CLOCK_MONOTONIC), start) / 1e6);
+	start = NsAdd(NsNow(CLOCK_MONOTONIC), START_DELAY_NS);
+	for(w = 0; w < nw; w++)
+		if(workers[w].ntasks)
+			DispStart(&workers[w].d, start);
+	pthread_barrier_wait(&start_barrier);
+
+	/* Ok. Threads shall run. Print the statistics on demand (SIGUSR1) and at termination (CTRL+C) */
+	printf("%d tasks on %d workers. Send SIGUSR1 (kill -USR1 %d) to print the job statistics\n\r", n, nw, getpid());
+	do {
+		sigwait(&sigset, &sig);
+		for(w = 0; w < nw; w++) {
+			if(workers[w].ntasks == 0)
+				continue;
+			snprintf(label, sizeof(label), "Worker %d", w);
+			DispPrint(&workers[w].d, label);
+		}
+		for(i = 0; i < n; i++)
+			DispTaskPrint(&dtasks[i], params[i].name);
+	} while(sig == SIGUSR1);
+
+	return 0;
+}
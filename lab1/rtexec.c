@@ -0,0 +1,504 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Periodic executive: runs a whole task set in a single process
+ *
+ * Generalizes the Thread_1_code template of a1/a2/a3. The task set
+ * (period, offset, deadline, priority, policy, CPU set and workload
+ * of each task) is read from a task table file (see taskset.h).
+ * All tasks share the same instrumentation: job statistics (stats.h)
+ * and a binary event trace (rtexec.trace, task id = line order).
+ *
+ * Tasks with policy DEADLINE run under SCHED_DEADLINE (EDF + CBS): the
+ * kernel enforces runtime/deadline/period and each job ends with
+ * sched_yield(), which gives back the unused budget and suspends the
+ * thread until the next period. The job statistics are the same as for
+ * FIFO tasks, so both policies can be compared directly.
+ *
+ * Tasks with CPUS auto are partitioned to the online cores before the
+ * start (first-fit or worst-fit decreasing with a response time check
+ * per core, see partition.h). Their WCET is the declared wcet= or, if
+ * missing, the longest of WCET_RUNS dry runs of the longest execution
+ * time of the workload plus a margin.
+ *
+ * FIFO/RR/OTHER tasks wait for each release with a plain clock_nanosleep
+ * or the back-end given by release= (sleep-then-spin, POSIX timer or
+ * timerfd, see release.h).
+ *
+ * Tasks with par=N split each job over N threads: the task thread and
+ * N-1 workers spawned before the start, pinned one per core of the task
+ * CPU set (fork-join, see forkjoin.h). Their makespan and barrier
+ * overhead are reported with the job statistics.
+ *
+ * Tasks with cs=RES:T run a critical section of T ns on resource RES at
+ * the start of each job (taken out of the job execution time), with the
+ * resource access protocol given on the command line (see resource.h).
+ * The blocking per job of the task and the lock waits and critical
+ * sections of each resource are reported with the job statistics.
+ *
+ * Before the first release every task thread prefaults its stack and
+ * runs its workload dry until the execution time is stable (warmup.h),
+ * with the process memory locked. The start time is set only when all
+ * the tasks are warm, so every job is measured, from the first one.
+ *
+ * Usage: rtexec TASKFILE [ff|wf] [KERNEL] [PROTOCOL]
+ *   ff|wf:    partitioning heuristic (default wf)
+ *   KERNEL:   integration kernel of the load, scalar (default), mul, sse,
+ *             avx2, avx512 or best (see kernels.h)
+ *   PROTOCOL: resource access protocol of the critical sections, none,
+ *             pip or pcp (default, also used by the partitioning)
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <math.h>
+#include <sys/syscall.h>
+
+#include "../common/nstime.h" // 64-bit ns time arithmetic
+#include "../common/stats.h" // Job latency histograms
+#include "../common/trace.h" // Binary event trace
+#include "../common/partition.h" // Task to core assignment
+#include "../common/release.h" // Sleep or hybrid sleep-then-spin release
+#include "../common/warmup.h" // Memory locking and dry runs before the first job
+#include "../common/workload.h" // Calibrated execution times
+#include "../common/kernels.h" // Scalar and SIMD integration kernels
+#include "../common/forkjoin.h" // Jobs split over several cores
+#include "../common/resource.h" // Priority inheritance / ceiling mutexes
+#include "taskset.h"
+
+
+/* ***********************************************
+* App specific defines
+* ***********************************************/
+#define START_DELAY_NS (100*1000*1000)	// Time between the end of the warm-up and the first release
+#define WCET_RUNS 10					// Dry runs to measure the WCET of the tasks to partition
+#define WCET_MARGIN 1.2					// Measured WCET safety factor
+#define MAX_RES 16						// Resources (cs=) of the task set
+
+
+/* ***********************************************
+* SCHED_DEADLINE parameters (no glibc wrapper for sched_setattr)
+* ***********************************************/
+struct sched_attr {
+	uint32_t size;
+	uint32_t sched_policy;
+	uint64_t sched_flags;
+	int32_t sched_nice;
+	uint32_t sched_priority;
+	uint64_t sched_runtime;		// ns
+	uint64_t sched_deadline;	// ns
+	uint64_t sched_period;		// ns
+};
+
+
+/* ***********************************************
+* Task descriptor
+* ***********************************************/
+struct task {
+	struct task_param p;		// Parameters from the task table
+	int id;						// Task id (trace)
+	pthread_t thread;
+	struct job_stats stats;
+	struct trace_ring trace;
+	struct release release;		// Release mode and wake-up statistics
+	struct warmup warm;			// Warm-up of the task thread
+	struct workload work;		// Execution time of the jobs
+	struct fj_pool *pool;		// Fork-join pool (par=N), NULL for single thread jobs
+	struct resource *res[TASK_MAX_CS];	// Resource of each critical section
+	struct res_user block;		// Blocking per job on the resources
+};
+
+
+/* ***********************************************
+* Prototypes
+* ***********************************************/
+void *Task_code(void *arg);
+void Dry_Work(void *arg);
+void Run_Job(struct task *t);
+int Setup_Resources(struct task *tasks, int n, int protocol);
+int SetDeadline(const struct task_param *p);
+uint64_t MeasureWcet(nstime_t exec);
+
+
+/* ***********************************************
+* Global variables
+* ***********************************************/
+nstime_t start_time;			// Common time reference for the task offsets (ns)
+pthread_barrier_t start_barrier;	// Tasks warm (first wait), start_time set (second wait)
+struct resource resources[MAX_RES];	// Shared resources, created before the start
+int nres;
+
+
+/* *************************
+* Periodic task code
+* **************************/
+
+void *Task_code(void *arg)
+{
+	struct task *t = (struct task *) arg;
+
+	/* Time variables (ns) */
+	nstime_t ts, 		// thread next activation time (absolute)
+			tr, 		// scheduled release time of current job (absolute)
+			ta, 		// activation time of current thread activation (absolute)
+			tf, 		// finish time of current job (absolute)
+			tit, 		// thread inter-arrival time,
+			ta_ant, 	// activation time of last instance (absolute),
+			tp; 		// Thread period
+
+	int niter = 0; 	// Activation counter
+	int skipped;	// Releases skipped by the kernel (DEADLINE)
+
+	/* Fork-join tasks: spawn and pin the workers */
+	if(t->pool && FjInit(t->pool, t->p.par, &t->p.cpus, t->p.policy, t->p.prio)) {
+		printf("Task %s: cannot start %d fork-join threads, the jobs run on one thread\n\r", t->p.name, t->p.par);
+		t->pool = NULL;
+	}
+
+	/* Warm-up, then wait for all the tasks and for main() to set the start time */
+	WarmupThread(&t->warm);
+	WarmupWork(&t->warm, Dry_Work, t, WARMUP_MAX_RUNS);
+	if(t->pool)
+		FjReset(t->pool);
+	pthread_barrier_wait(&start_barrier);
+	pthread_barrier_wait(&start_barrier);
+
+	/* Set absolute activation time of first instance */
+	tp = t->p.period;
+	ts = NsAdd(start_time, t->p.offset);
+
+	/* EDF tasks: the CBS period starts when the thread becomes SCHED_DEADLINE at the first release */
+	if(t->p.policy == SCHED_DEADLINE) {
+		ReleaseWait(&t->release, ts);
+		if(SetDeadline(&t->p))
+			return NULL;
+	}
+
+	/* Periodic jobs ...*/
+	while(1) {
+
+		/* Wait until next cycle */
+		if(t->p.policy != SCHED_DEADLINE)
+			ReleaseWait(&t->release, ts);
+		else if(niter > 0)
+			sched_yield(); // End of job. The kernel wakes the thread at the next period
+		ta = NsNow(CLOCK_MONOTONIC);
+
+		/* EDF tasks: the kernel picks the CBS phase, so the release grid is anchored to the first
+		   activation. Releases missed while throttled are skipped, resync to the last one */
+		if(t->p.policy == SCHED_DEADLINE) {
+			if(niter == 0)
+				ts = ta;
+			for(skipped = 0; NsAdd(ts, tp) <= ta; skipped++)
+				ts = NsAdd(ts, tp);
+			if(skipped)
+				TraceEmit(&t->trace, ta, TRACE_OVERRUN, skipped);
+		}
+		tr = ts;
+		ts = NsAdd(ts, tp);
+
+		niter++;
+
+		/* Compute latency and jitter */
+		if(niter == 1)
+			ta_ant = ta;
+		tit = NsSubSat(ta, ta_ant);
+		TraceEmit(&t->trace, ta, TRACE_RELEASE, tit);
+		if(niter > 1)
+			HistRecord(&t->stats.iat, tit);
+		ta_ant = ta;
+
+		/* Do the actual processing */
+		Run_Job(t);
+
+		/* Lateness, execution and response time of the job */
+		tf = NsNow(CLOCK_MONOTONIC);
+		TraceEmit(&t->trace, tf, TRACE_JOB_END, NsSubSat(tf, ta));
+		StatsJob(&t->stats, tr, ta, tf);
+	}
+
+	return NULL;
+}
+
+/* *************************
+* main()
+* **************************/
+
+int main(int argc, char *argv[])
+{
+	struct task_param params[MAX_TASKS];
+	struct task *tasks;
+	struct sched_param parm;
+	pthread_attr_t attr;
+	sigset_t sigset;
+	int i, n, err, sig, core, ncores, heuristic = PART_WFD, partition = 0, kernel = KERN_SCALAR, protocol = RES_PCP;
+	double dl_bw = 0, util, util_total;
+	nstime_t warm_start;
+	char label[64];
+
+	/* Process input args */
+	if(argc < 2 || argc > 5) {
+		printf("Usage: %s TASKFILE [ff|wf] [KERNEL] [PROTOCOL], where TASKFILE is a task table (see taskset.h), KERNEL is "
+			"scalar (default), mul, sse, avx2, avx512 or best and PROTOCOL is none, pip or pcp (default)\n\r", argv[0]);
+		return -1;
+	}
+	if(argc >= 3) {
+		if(!strcmp(argv[2], "ff"))
+			heuristic = PART_FFD;
+		else if(strcmp(argv[2], "wf")) {
+			printf("Invalid partitioning heuristic %s, must be ff or wf\n\r", argv[2]);
+			return -1;
+		}
+	}
+	if(argc >= 4 && ((kernel = KernParse(argv[3])) < 0 || WorkloadKernel(kernel))) {
+		printf("Invalid kernel %s, must be scalar, mul, sse, avx2, avx512 or best (and supported by this CPU)\n\r", argv[3]);
+		return -1;
+	}
+	if(argc == 5 && (protocol = ResParse(argv[4])) < 0) {
+		printf("Invalid resource access protocol %s, must be none, pip or pcp\n\r", argv[4]);
+		return -1;
+	}
+
+	n = TasksetLoad(argv[1], params, MAX_TASKS);
+	if(n < 0)
+		return -1;
+
+	/* Lock memory and prefault the heap before measuring or running anything */
+	WarmupProcess();
+	printf("Workload calibration: %.3f ns per sub-interval (%s kernel)\n\r", WorkloadCalibrate(), KernName(kernel));
+
+	/* Assign a core to the CPUS auto tasks */
+	for(i = 0; i < n; i++) {
+		if(!params[i].autocpu)
+			continue;
+		partition = 1;
+		if(params[i].wcet == 0) {
+			params[i].wcet = MeasureWcet(WorkloadMax(&params[i].workload));
+			printf("Task %s: measured WCET %lu ns\n\r", params[i].name, params[i].wcet);
+		}
+	}
+	if(partition) {
+		ncores = sysconf(_SC_NPROCESSORS_ONLN);
+		if(TasksetPartition(params, n, ncores, heuristic, protocol == RES_PIP ? AN_PIP : AN_PCP))
+			return -1;
+		for(i = 0; i < n; i++) {
+			if(!params[i].autocpu)
+				continue;
+			for(core = 0; !CPU_ISSET(core, &params[i].cpus); core++);
+			printf("Task %s: core %d (%s over %d cores)\n\r", params[i].name, core, PartitionName(heuristic), ncores);
+		}
+	}
+
+	tasks = calloc(n, sizeof(struct task));
+	if(tasks == NULL) {
+		printf("Not enough memory for %d tasks\n\r", n);
+		return -1;
+	}
+
+	printf("%-16s %12s %12s %12s %4s %-5s %3s %s\n\r", "Task", "Period", "Offset", "Deadline", "Prio", "Pol", "CPU", "Workload (us)");
+	for(i = 0; i < n; i++) {
+		tasks[i].p = params[i];
+		if(params[i].par > 1 && (tasks[i].pool = malloc(sizeof(struct fj_pool))) == NULL) {
+			printf("Not enough memory for the fork-join pool of %s\n\r", params[i].name);
+			return -1;
+		}
+		tasks[i].id = i + 1;
+		StatsInit(&tasks[i].stats, params[i].deadline);
+		TraceInit(&tasks[i].trace, tasks[i].id);
+		ReleaseInit(&tasks[i].release, &params[i].release);
+		WorkloadInit(&tasks[i].work, &params[i].workload, i + 1);
+		printf("%-16s %12lu %12lu %12lu %4d %-5s %3d %s\n\r", params[i].name, params[i].period, params[i].offset,
+			params[i].deadline, params[i].prio, PolicyName(params[i].policy), CPU_COUNT(&params[i].cpus),
+			WorkloadFormat(&params[i].workload, label, sizeof(label)));
+		if(params[i].par > 1)
+			printf("%-16s %d threads per job\n\r", "", params[i].par);
+		if(params[i].policy == SCHED_DEADLINE)
+			dl_bw += (double) params[i].runtime / params[i].period;
+	}
+	if(dl_bw > 0)
+		printf("SCHED_DEADLINE reserved bandwidth: %.3f (default admission limit: %.2f)\n\r",
+			dl_bw, 0.95 * sysconf(_SC_NPROCESSORS_ONLN)); // sched_rt_runtime_us / sched_rt_period_us per core
+	if(Setup_Resources(tasks, n, protocol))
+		return -1;
+
+	/* Block report/termination signals. The task threads inherit the mask, so only main() gets them */
+	sigemptyset(&sigset);
+	sigaddset(&sigset, SIGUSR1);
+	sigaddset(&sigset, SIGINT);
+	sigaddset(&sigset, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+	if(TraceStart("rtexec.trace"))
+		return -1;
+
+	/* Create the periodic threads. They warm up and wait for the start time */
+	pthread_barrier_init(&start_barrier, NULL, n + 1);
+	warm_start = NsNow(CLOCK_MONOTONIC);
+	for(i = 0; i < n; i++) {
+		parm.sched_priority = tasks[i].p.prio;
+		pthread_attr_init(&attr);
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		/* DEADLINE tasks start as OTHER and switch policy in Task_code() */
+		pthread_attr_setschedpolicy(&attr, tasks[i].p.policy == SCHED_DEADLINE ? SCHED_OTHER : tasks[i].p.policy);
+		pthread_attr_setschedparam(&attr, &parm);
+		pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &tasks[i].p.cpus);
+
+		err = pthread_create(&tasks[i].thread, &attr, Task_code, &tasks[i]);
+		pthread_attr_destroy(&attr);
+		if(err != 0) {
+			printf("\n\r Error creating Thread %s [%s]\n\r", tasks[i].p.name, strerror(err));
+			return -1;
+		}
+	}
+
+	/* All the offsets are relative to the same start time, set once every task is warm */
+	pthread_barrier_wait(&start_barrier);
+	printf("Warm-up of %d tasks: %.3f ms\n\r", n, NsSubSat(NsNow(CLOCK_MONOTONIC), warm_start) / 1e6);
+	for(i = 0; i < n; i++)
+		WarmupPrint(&tasks[i].warm, tasks[i].p.name);
+	start_time = NsAdd(NsNow(CLOCK_MONOTONIC), START_DELAY_NS);
+	pthread_barrier_wait(&start_barrier);
+
+	/* Ok. Threads shall run. Print the statistics on demand (SIGUSR1) and at termination (CTRL+C) */
+	printf("Send SIGUSR1 (kill -USR1 %d) to print the job statistics\n\r", getpid());
+	do {
+		sigwait(&sigset, &sig);
+		util_total = 0;
+		for(i = 0; i < n; i++) {
+			StatsPrint(&tasks[i].stats, tasks[i].p.name);
+			if(tasks[i].p.policy != SCHED_DEADLINE)
+				ReleasePrint(&tasks[i].release, tasks[i].p.name);
+			if(tasks[i].pool)
+				FjPrint(tasks[i].pool, tasks[i].p.name);
+			if(tasks[i].p.ncs)
+				ResUserPrint(&tasks[i].block, tasks[i].p.name);
+			util = (double) HistMean(&tasks[i].stats.exec) / tasks[i].p.period;
+			printf("  %s measured utilization: %.3f\n\r", tasks[i].p.name, util);
+			util_total += util;
+		}
+		printf("Total measured utilization: %.3f\n\r", util_total);
+		for(i = 0; i < nres; i++)
+			ResPrint(&resources[i]);
+	} while(sig == SIGUSR1);
+	TraceStop();
+
+	return 0;
+}
+
+/* ***********************************************
+* Auxiliary functions
+* ************************************************/
+
+// Switches the calling thread to SCHED_DEADLINE with the task budget. Returns 0 if Ok
+int SetDeadline(const struct task_param *p)
+{
+	struct sched_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.sched_policy = SCHED_DEADLINE;
+	attr.sched_runtime = p->runtime;
+	attr.sched_deadline = p->deadline;
+	attr.sched_period = p->period;
+
+	if(syscall(SYS_sched_setattr, 0, &attr, 0)) {
+		printf("Task %s: sched_setattr(SCHED_DEADLINE) failed [%s]\n\r", p->name, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+// Longest execution time of WCET_RUNS runs of exec ns of load, times WCET_MARGIN (ns)
+uint64_t MeasureWcet(nstime_t exec)
+{
+	nstime_t t0, c, wcet = 0;
+	int i;
+
+	for(i = 0; i < WCET_RUNS; i++) {
+		t0 = NsNow(CLOCK_MONOTONIC);
+		WorkloadRun(exec);
+		c = NsSubSat(NsNow(CLOCK_MONOTONIC), t0);
+		if(c > wcet)
+			wcet = c;
+	}
+	return wcet * WCET_MARGIN;
+}
+
+// One job: the critical sections (cs=), taken out of the drawn execution time, then the rest of the load
+void Run_Job(struct task *t)
+{
+	nstime_t exec = WorkloadNext(&t->work);
+	int k;
+
+	for(k = 0; k < t->p.ncs; k++) {
+		ResLock(t->res[k], &t->block);
+		WorkloadRun(t->p.cs[k].len);
+		ResUnlock(t->res[k]);
+		exec = NsSubSat(exec, t->p.cs[k].len);
+	}
+	if(t->p.ncs)
+		ResJobEnd(&t->block);
+
+	if(t->pool)
+		FjJob(t->pool, exec);
+	else
+		WorkloadRun(exec);
+}
+
+// Creates one resource per name used by cs=, with the ceiling of its users. Returns 0 if Ok
+int Setup_Resources(struct task *tasks, int n, int protocol)
+{
+	char names[MAX_RES][RES_NAME_LEN];
+	int ceiling[MAX_RES] = {0}, i, k, r;
+
+	for(i = 0; i < n; i++) {
+		ResUserInit(&tasks[i].block);
+		if(tasks[i].p.ncs && tasks[i].p.policy == SCHED_DEADLINE) {
+			printf("Task %s: critical sections are not supported for DEADLINE tasks\n\r", tasks[i].p.name);
+			return -1;
+		}
+		for(k = 0; k < tasks[i].p.ncs; k++) {
+			for(r = 0; r < nres && strcmp(names[r], tasks[i].p.cs[k].res); r++);
+			if(r == MAX_RES) {
+				printf("Too many resources, at most %d\n\r", MAX_RES);
+				return -1;
+			}
+			if(r == nres)
+				snprintf(names[nres++], RES_NAME_LEN, "%s", tasks[i].p.cs[k].res);
+			if(tasks[i].p.prio > ceiling[r])
+				ceiling[r] = tasks[i].p.prio;
+			tasks[i].res[k] = &resources[r];
+		}
+	}
+
+	/* The ceiling is a SCHED_FIFO priority, at least 1 for resources of OTHER tasks only */
+	for(r = 0; r < nres; r++) {
+		if(ResInit(&resources[r], names[r], protocol, ceiling[r] > 0 ? ceiling[r] : 1))
+			return -1;
+		printf("Resource %s: %s, ceiling %d\n\r", names[r], ResName(protocol), resources[r].ceiling);
+	}
+	return 0;
+}
+
+// Longest job of a task, with the signature of a warm-up job. Does not advance the generator
+void Dry_Work(void *arg)
+{
+	struct task *t = (struct task *) arg;
+
+	if(t->pool)
+		FjJob(t->pool, WorkloadMax(&t->p.workload));
+	else
+		WorkloadRun(WorkloadMax(&t->p.workload));
+}
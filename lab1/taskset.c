@@ -0,0 +1,391 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Task table parser for the periodic executive (rtexec)
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include "../common/partition.h"
+#include "../common/forkjoin.h"
+#include "taskset.h"
+
+#define LINE_LEN 256
+#define NUM_FIELDS 8		// Mandatory fields
+#define MAX_OPTIONS 8		// Optional KEY=VALUE fields
+
+// Converts "10ms", "250us", "1.5s", "800ns" or "500" (us) to ns. Returns 0 if Ok
+int ParseTime(const char *str, uint64_t *ns)
+{
+	char *end;
+	double v = strtod(str, &end);
+
+	if(end == str || v < 0)
+		return -1;
+	if(*end == '\0' || !strcmp(end, "us"))
+		v *= 1e3;
+	else if(!strcmp(end, "ms"))
+		v *= 1e6;
+	else if(!strcmp(end, "s"))
+		v *= 1e9;
+	else if(strcmp(end, "ns"))
+		return -1;
+
+	*ns = (uint64_t) (v + 0.5);
+	return 0;
+}
+
+// Converts "all" or a list like "0,2-3" to a CPU set. Returns 0 if Ok
+static int ParseCpus(const char *str, cpu_set_t *set)
+{
+	char *end;
+	long a, b, i;
+
+	CPU_ZERO(set);
+	if(!strcmp(str, "all")) {
+		for(i = 0; i < CPU_SETSIZE; i++)
+			CPU_SET(i, set);
+		return 0;
+	}
+
+	while(*str) {
+		a = strtol(str, &end, 10);
+		if(end == str || a < 0 || a >= CPU_SETSIZE)
+			return -1;
+		b = a;
+		if(*end == '-') {
+			str = end + 1;
+			b = strtol(str, &end, 10);
+			if(end == str || b < a || b >= CPU_SETSIZE)
+				return -1;
+		}
+		for(i = a; i <= b; i++)
+			CPU_SET(i, set);
+		if(*end == ',')
+			end++;
+		else if(*end != '\0')
+			return -1;
+		str = end;
+	}
+	return CPU_COUNT(set) ? 0 : -1;
+}
+
+static int ParsePolicy(const char *str, int *policy)
+{
+	if(!strcmp(str, "FIFO"))
+		*policy = SCHED_FIFO;
+	else if(!strcmp(str, "RR"))
+		*policy = SCHED_RR;
+	else if(!strcmp(str, "OTHER"))
+		*policy = SCHED_OTHER;
+	else if(!strcmp(str, "DEADLINE"))
+		*policy = SCHED_DEADLINE;
+	else
+		return -1;
+	return 0;
+}
+
+const char *PolicyName(int policy)
+{
+	switch(policy) {
+		case SCHED_FIFO: return "FIFO";
+		case SCHED_RR: return "RR";
+		case SCHED_OTHER: return "OTHER";
+		case SCHED_DEADLINE: return "DL";
+		default: return "?";
+	}
+}
+
+// Parses one task line (already split in fields). Returns 0 if Ok
+static int ParseTask(char **f, struct task_param *t)
+{
+	char *end;
+
+	if(strlen(f[0]) >= TASK_NAME_LEN) {
+		printf("name too long");
+		return -1;
+	}
+	strcpy(t->name, f[0]);
+
+	if(ParseTime(f[1], &t->period) || t->period == 0) {
+		printf("invalid period '%s'", f[1]);
+		return -1;
+	}
+	if(ParseTime(f[2], &t->offset)) {
+		printf("invalid offset '%s'", f[2]);
+		return -1;
+	}
+	if(ParseTime(f[3], &t->deadline)) {
+		printf("invalid deadline '%s'", f[3]);
+		return -1;
+	}
+	if(t->deadline == 0)
+		t->deadline = t->period; // Implicit deadline
+
+	if(ParsePolicy(f[5], &t->policy)) {
+		printf("invalid policy '%s', must be FIFO, RR, OTHER or DEADLINE", f[5]);
+		return -1;
+	}
+	t->prio = strtol(f[4], &end, 10);
+	if(*end != '\0' || ((t->policy == SCHED_OTHER || t->policy == SCHED_DEADLINE) && t->prio != 0)
+			|| ((t->policy == SCHED_FIFO || t->policy == SCHED_RR) && (t->prio < 1 || t->prio > 99))) {
+		printf("invalid priority '%s', must vary from 1 to 99 (0 for OTHER and DEADLINE)", f[4]);
+		return -1;
+	}
+	if(!strcmp(f[6], "auto")) {
+		if(t->policy != SCHED_FIFO && t->policy != SCHED_RR) {
+			printf("CPUS auto is only valid for FIFO and RR tasks");
+			return -1;
+		}
+		t->autocpu = 1; // All the cores until partitioned
+	}
+	if(ParseCpus(t->autocpu ? "all" : f[6], &t->cpus)) {
+		printf("invalid CPU set '%s'", f[6]);
+		return -1;
+	}
+	if(t->policy == SCHED_DEADLINE && strcmp(f[6], "all")) {
+		printf("DEADLINE tasks must use CPUS all (admission control is done over all the cores)");
+		return -1;
+	}
+	if(WorkloadParse(f[7], &t->workload)) {
+		printf("invalid workload '%s', must be C, uniform:LO:HI, bimodal:LO:HI:P or pareto:MIN:ALPHA:MAX", f[7]);
+		return -1;
+	}
+	return 0;
+}
+
+// Parses one optional KEY=VALUE field. Returns 0 if Ok
+static int ParseOption(char *opt, struct task_param *t)
+{
+	char *val = strchr(opt, '='), *sep;
+
+	if(val == NULL) {
+		printf("invalid option '%s', must be KEY=VALUE", opt);
+		return -1;
+	}
+	*val++ = '\0';
+
+	if(!strcmp(opt, "runtime")) {
+		if(ParseTime(val, &t->runtime) || t->runtime == 0) {
+			printf("invalid runtime '%s'", val);
+			return -1;
+		}
+	} else if(!strcmp(opt, "wcet")) {
+		if(ParseTime(val, &t->wcet) || t->wcet == 0) {
+			printf("invalid wcet '%s'", val);
+			return -1;
+		}
+	} else if(!strcmp(opt, "jitter")) {
+		if(ParseTime(val, &t->jitter)) {
+			printf("invalid jitter '%s'", val);
+			return -1;
+		}
+	} else if(!strcmp(opt, "release")) {
+		if(ReleaseParse(val, &t->release)) {
+			printf("invalid release mode '%s', must be sleep, hybrid[:GUARD], timer or timerfd", val);
+			return -1;
+		}
+	} else if(!strcmp(opt, "seed")) {
+		t->workload.seed = strtoull(val, &sep, 10);
+		if(*sep != '\0' || t->workload.seed == 0) {
+			printf("invalid seed '%s'", val);
+			return -1;
+		}
+	} else if(!strcmp(opt, "par")) {
+		t->par = strtol(val, &sep, 10);
+		if(*sep != '\0' || t->par < 1 || t->par > FJ_MAX) {
+			printf("invalid number of threads per job '%s' (max %d)", val, FJ_MAX);
+			return -1;
+		}
+	} else if(!strcmp(opt, "copies")) {
+		t->copies = strtol(val, &sep, 10);
+		if(*sep != '\0' || t->copies < 1) {
+			printf("invalid number of copies '%s'", val);
+			return -1;
+		}
+	} else if(!strcmp(opt, "cs")) {
+		sep = strchr(val, ':');
+		if(sep == NULL || sep == val || sep - val >= TASK_NAME_LEN || t->ncs == TASK_MAX_CS
+				|| ParseTime(sep + 1, &t->cs[t->ncs].len)) {
+			printf("invalid critical section '%s', must be RES:TIME (max %d per task)", val, TASK_MAX_CS);
+			return -1;
+		}
+		*sep = '\0';
+		strcpy(t->cs[t->ncs++].res, val);
+	} else {
+		printf("unknown option '%s'", opt);
+		return -1;
+	}
+	return 0;
+}
+
+// Checks the options that depend on the policy. Returns 0 if Ok
+static int CheckTask(struct task_param *t)
+{
+	if(t->policy == SCHED_DEADLINE) {
+		if(t->runtime == 0) {
+			printf("DEADLINE tasks need a runtime=BUDGET option");
+			return -1;
+		}
+		if(t->runtime > t->deadline || t->deadline > t->period) {
+			printf("DEADLINE tasks need runtime <= deadline <= period");
+			return -1;
+		}
+		if(t->release.mode != REL_SLEEP) {
+			printf("DEADLINE tasks are released by the kernel, release= is not valid");
+			return -1;
+		}
+	}
+	if(t->par > 1 && (t->autocpu || (t->policy != SCHED_FIFO && t->policy != SCHED_RR))) {
+		printf("par= needs a FIFO or RR task with a CPU list (not auto)");
+		return -1;
+	}
+	return 0;
+}
+
+// Replicates task n copies times, from tasks[n] on. Returns 0 if Ok
+static int ExpandCopies(struct task_param *tasks, int n, int max)
+{
+	struct task_param *t = &tasks[n];
+	char base[TASK_NAME_LEN];
+	int k;
+
+	if(n + t->copies > max) {
+		printf("too many tasks (max %d)", max);
+		return -1;
+	}
+	if(strlen(t->name) + 1 + snprintf(NULL, 0, "%d", t->copies - 1) >= TASK_NAME_LEN) {
+		printf("name too long for %d copies", t->copies);
+		return -1;
+	}
+
+	strcpy(base, t->name);
+	for(k = t->copies - 1; k >= 0; k--) {
+		tasks[n + k] = *t;
+		snprintf(tasks[n + k].name, TASK_NAME_LEN, "%s.%d", base, k);
+		tasks[n + k].offset = t->offset + k * t->period / t->copies;
+		if(t->workload.seed)
+			tasks[n + k].workload.seed = t->workload.seed + k;
+	}
+	return 0;
+}
+
+// Loads up to max tasks from the task table file. Returns the number of tasks or -1 on error
+int TasksetLoad(const char *path, struct task_param *tasks, int max)
+{
+	char line[LINE_LEN], *f[NUM_FIELDS + MAX_OPTIONS + 1], *p;
+	int n = 0, nf, i, err, lineno = 0;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if(fp == NULL) {
+		printf("Cannot open task table %s\n\r", path);
+		return -1;
+	}
+
+	while(fgets(line, sizeof(line), fp) != NULL) {
+		lineno++;
+		if((p = strchr(line, '#')) != NULL)
+			*p = '\0';
+
+		/* Split in whitespace separated fields */
+		nf = 0;
+		for(p = strtok(line, " \t\r\n"); p != NULL && nf <= NUM_FIELDS + MAX_OPTIONS; p = strtok(NULL, " \t\r\n"))
+			f[nf++] = p;
+		if(nf == 0)
+			continue;
+
+		if(nf < NUM_FIELDS || nf > NUM_FIELDS + MAX_OPTIONS) {
+			printf("%s:%d: expected %d fields and up to %d options\n\r", path, lineno, NUM_FIELDS, MAX_OPTIONS);
+			fclose(fp);
+			return -1;
+		}
+		if(n == max) {
+			printf("%s:%d: too many tasks (max %d)\n\r", path, lineno, max);
+			fclose(fp);
+			return -1;
+		}
+
+		memset(&tasks[n], 0, sizeof(tasks[n]));
+		err = ParseTask(f, &tasks[n]);
+		for(i = NUM_FIELDS; i < nf && !err; i++)
+			err = ParseOption(f[i], &tasks[n]);
+		if(!err)
+			err = CheckTask(&tasks[n]);
+		if(!err && tasks[n].copies > 1)
+			err = ExpandCopies(tasks, n, max);
+		if(err) {
+			printf(" (%s:%d)\n\r", path, lineno);
+			fclose(fp);
+			return -1;
+		}
+		n += tasks[n].copies > 1 ? tasks[n].copies : 1;
+	}
+	fclose(fp);
+
+	if(n == 0)
+		printf("%s: no tasks defined\n\r", path);
+	return n ? n : -1;
+}
+
+// Pins the CPUS auto tasks to one of the first ncores cores (see partition.h). FIFO/RR tasks
+// with a CPU list are analyzed on their lowest core. Every FIFO/RR task needs a wcet.
+// DEADLINE tasks (C = wcet, or runtime) preempt the FIFO/RR tasks of every core.
+// Returns 0 if Ok, -1 if some task could not be placed
+int TasksetPartition(struct task_param *tasks, int n, int ncores, int heuristic, int protocol)
+{
+	struct an_task t[MAX_TASKS];
+	int idx[MAX_TASKS];
+	int i, k, na = 0, core, unplaced;
+
+	for(i = 0; i < n && na < MAX_TASKS; i++) {
+		if(tasks[i].policy == SCHED_OTHER)
+			continue;
+		if(tasks[i].wcet == 0 && tasks[i].policy != SCHED_DEADLINE) {
+			printf("Task %s: no WCET, cannot partition\n\r", tasks[i].name);
+			return -1;
+		}
+		memset(&t[na], 0, sizeof(t[na]));
+		strcpy(t[na].name, tasks[i].name);
+		t[na].C = tasks[i].wcet ? tasks[i].wcet : tasks[i].runtime;
+		t[na].T = tasks[i].period;
+		t[na].D = tasks[i].deadline;
+		t[na].J = tasks[i].jitter;
+		t[na].prio = tasks[i].prio;
+		t[na].policy = tasks[i].policy == SCHED_DEADLINE ? AN_EDF : AN_FP; // Load that every core must leave
+		if(tasks[i].autocpu)
+			t[na].core = PART_AUTO;
+		else {
+			for(core = 0; !CPU_ISSET(core, &tasks[i].cpus); core++);
+			t[na].core = core;
+		}
+		t[na].ncs = tasks[i].ncs < AN_MAX_CS ? tasks[i].ncs : AN_MAX_CS;
+		for(k = 0; k < t[na].ncs; k++) {
+			strcpy(t[na].cs[k].res, tasks[i].cs[k].res);
+			t[na].cs[k].len = tasks[i].cs[k].len;
+		}
+		idx[na++] = i;
+	}
+
+	unplaced = Partition(t, na, ncores, heuristic, protocol);
+
+	for(k = 0; k < na; k++) {
+		i = idx[k];
+		if(!tasks[i].autocpu)
+			continue;
+		if(t[k].core == PART_AUTO) {
+			printf("Task %s: does not fit in any of the %d cores (%s)\n\r", tasks[i].name, ncores, PartitionName(heuristic));
+			continue;
+		}
+		CPU_ZERO(&tasks[i].cpus);
+		CPU_SET(t[k].core, &tasks[i].cpus);
+	}
+	return unplaced ? -1 : 0;
+}
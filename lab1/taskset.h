@@ -0,0 +1,82 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Task table for the periodic executive (rtexec)
+ *
+ * One task per line, '#' starts a comment:
+ *   NAME PERIOD OFFSET DEADLINE PRIO POLICY CPUS WORKLOAD [KEY=VALUE ...]
+ * Times accept the suffixes ns, us, ms and s (default is us).
+ * DEADLINE 0 means implicit deadline (equal to the period).
+ * POLICY is FIFO, RR, OTHER or DEADLINE. CPUS is "all", a list like 0,2-3
+ * or "auto" (FIFO/RR only): the task is given a single core by the
+ * partitioner (TasksetPartition), which needs its WCET.
+ * WORKLOAD is the execution time of each job, constant or drawn from a
+ * distribution (uniform:LO:HI, bimodal:LO:HI:P or pareto:MIN:ALPHA:MAX,
+ * see workload.h). The load is calibrated to the host at startup.
+ * Options:
+ *   runtime=T   CPU budget per period (mandatory for DEADLINE, PRIO must
+ *               be 0 and CPUS must be all)
+ *   wcet=T      Declared worst-case execution time (schedulability analysis)
+ *   jitter=T    Jitter of the execution for the analysis, e.g. period - budget
+ *               for a deferrable server (see analysis.h)
+ *   cs=RES:T    Critical section of T on resource RES, run by rtexec at the start
+ *               of each job and used by the analysis, may repeat (see resource.h)
+ *   release=M   Release mode of FIFO/RR/OTHER tasks: sleep (default), hybrid,
+ *               hybrid:GUARD, timer or timerfd (see release.h)
+ *   seed=N      Seed of the execution time generator (default: task number,
+ *               copies use N, N+1, ...)
+ *   par=N       Splits each job over N threads on the cores of CPUS (fork-join,
+ *               see forkjoin.h). FIFO/RR with a CPU list only
+ *   copies=N    Replicates the task N times (NAME.0 .. NAME.N-1), with the
+ *               offsets spread evenly over the period
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef __TASKSET_H__
+#define __TASKSET_H__
+
+#include <sched.h> // cpu_set_t, requires _GNU_SOURCE
+#include <stdint.h>
+
+#include "../common/release.h"
+#include "../common/workload.h"
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6	// Not exported by older glibc
+#endif
+
+#define TASK_NAME_LEN 32
+#define MAX_TASKS 64
+#define TASK_MAX_CS 4		// Critical sections per task
+
+struct task_param {
+	char name[TASK_NAME_LEN];
+	uint64_t period;	// ns
+	uint64_t offset;	// ns, first release relative to the common start time
+	uint64_t deadline;	// ns, relative
+	int prio;			// 1..99 for FIFO/RR, 0 for OTHER
+	int policy;			// SCHED_FIFO, SCHED_RR, SCHED_OTHER or SCHED_DEADLINE
+	cpu_set_t cpus;		// Allowed cores
+	int autocpu;		// CPUS auto: cpus is set by TasksetPartition
+	struct workload_cfg workload; // Execution time of the jobs
+	uint64_t runtime;	// ns, SCHED_DEADLINE budget per period
+	uint64_t wcet;		// ns, declared WCET (0 if unknown)
+	uint64_t jitter;	// ns, analysis only
+	struct release_cfg release; // Release mode
+	int copies;			// Replicas of the table line
+	int par;			// Threads per job (fork-join), 1 for a plain job
+	int ncs;			// Critical sections (resource name and length in ns)
+	struct {
+		char res[TASK_NAME_LEN];
+		uint64_t len;
+	} cs[TASK_MAX_CS];
+};
+
+int TasksetLoad(const char *path, struct task_param *tasks, int max);
+int ParseTime(const char *str, uint64_t *ns);
+const char *PolicyName(int policy);
+int TasksetPartition(struct task_param *tasks, int n, int ncores, int heuristic, int protocol);
+
+#endif
@@ -0,0 +1,113 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * Decodes the binary trace files written by the trace drainer
+ * (see common/trace.h)
+ *
+ * Usage: tracedump FILE      prints every event
+ *        tracedump FILE -s   prints a per-task summary
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../common/trace.h"
+
+#define MAX_TASKS 256
+
+/* Per-task summary */
+struct task_summary {
+	uint64_t releases, ends, overruns;
+	uint64_t min_iat, max_iat, sum_iat, n_iat;
+	uint64_t max_exec;
+};
+
+const char *TypeName(uint32_t type)
+{
+	switch(type) {
+		case TRACE_RELEASE: return "release";
+		case TRACE_JOB_END: return "job_end";
+		case TRACE_SEQ: return "seq";
+		case TRACE_OVERRUN: return "overrun";
+		default: return "unknown";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	char magic[sizeof(TRACE_MAGIC)];
+	struct trace_event e;
+	struct task_summary *sum, *s;
+	FILE *fp;
+	int summary, i;
+
+	if(argc < 2 || argc > 3 || (argc == 3 && strcmp(argv[2], "-s"))) {
+		printf("Usage: %s FILE [-s], where FILE is a trace file and -s prints only a per-task summary\n\r", argv[0]);
+		return -1;
+	}
+	summary = (argc == 3);
+
+	fp = fopen(argv[1], "rb");
+	if(fp == NULL) {
+		printf("Cannot open %s\n\r", argv[1]);
+		return -1;
+	}
+	if(fread(magic, 1, strlen(TRACE_MAGIC), fp) != strlen(TRACE_MAGIC) || memcmp(magic, TRACE_MAGIC, strlen(TRACE_MAGIC))) {
+		printf("%s is not a trace file\n\r", argv[1]);
+		fclose(fp);
+		return -1;
+	}
+
+	sum = calloc(MAX_TASKS, sizeof(struct task_summary));
+	for(i = 0; i < MAX_TASKS; i++)
+		sum[i].min_iat = UINT64_MAX;
+
+	while(fread(&e, sizeof(e), 1, fp) == 1) {
+		if(!summary)
+			printf("%20lu task %3u %-8s %lu\n", e.ts, e.task, TypeName(e.type), e.payload);
+
+		s = &sum[e.task % MAX_TASKS];
+		switch(e.type) {
+			case TRACE_RELEASE:
+				s->releases++;
+				if(e.payload == 0) // First activation, no inter-arrival time
+					break;
+				if(e.payload < s->min_iat)
+					s->min_iat = e.payload;
+				if(e.payload > s->max_iat)
+					s->max_iat = e.payload;
+				s->sum_iat += e.payload;
+				s->n_iat++;
+				break;
+			case TRACE_JOB_END:
+				s->ends++;
+				if(e.payload > s->max_exec)
+					s->max_exec = e.payload;
+				break;
+			case TRACE_OVERRUN:
+				s->overruns += e.payload;
+				break;
+		}
+	}
+	fclose(fp);
+
+	for(i = 0; i < MAX_TASKS; i++) {
+		s = &sum[i];
+		if(s->releases == 0 && s->ends == 0)
+			continue;
+		printf("Task %d: releases: %lu / overruns: %lu", i, s->releases, s->overruns);
+		if(s->n_iat)
+			printf(" / inter-arrival min: %lu / mean: %lu / max: %lu", s->min_iat, s->sum_iat / s->n_iat, s->max_iat);
+		if(s->ends)
+			printf(" / max exec: %lu", s->max_exec);
+		printf("\n");
+	}
+	free(sum);
+
+	return 0;
+}
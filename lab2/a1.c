@@ -22,6 +22,11 @@
 #include <alchemy/task.h>
 #include <alchemy/timer.h>
 
+#include "../common/trace.h" // Binary event trace
+#include "../common/nstime.h" // 64-bit ns time arithmetic
+#include "../common/workload.h" // Calibrated execution times
+#include "../common/overrun.h" // Overrun policies
+
 #define MS_2_NS(ms)(ms*1000*1000) /* Convert ms to ns */
 #define NS_IN_SEC 1000000000L
 #define BOOT_ITER 10
@@ -31,6 +36,9 @@
  struct taskArgsStruct {
 	 RTIME taskPeriod_ns;
 	 int some_other_arg;
+	 struct trace_ring *trace;	// Event ring of the task
+	 nstime_t min_ita, max_ita;	// Observed inter-activation times in ns (after BOOT_ITER)
+	 struct overrun ovr;		// Overrun policy and counters
  };
 
 /* *******************
@@ -41,8 +49,10 @@
 
 #define TASK_A_PRIO 25 	// RT priority [0..99]
 #define TASK_A_PERIOD_NS MS_2_NS(1000)
+#define TASK_WORK_US 20000		// Heavy_Work execution time (us), calibrated at startup
 
 RT_TASK task_a_desc; // Task decriptor
+struct trace_ring task_a_trace; // Task event ring
 
 
 /* *********************
@@ -50,7 +60,7 @@ RT_TASK task_a_desc; // Task decriptor
 * **********************/
 void catch_signal(int sig); 	/* Catches CTRL + C to allow a controlled termination of the application */
 void wait_for_ctrl_c(void);
-void Heavy_Work(void);      	/* Load task */
+void Heavy_Work(double scale);	/* Load task */
 void task_code(void *args); 	/* Task body */
 
 
@@ -58,12 +68,28 @@ void task_code(void *args); 	/* Task body */
 * Main function
 * *******************/ 
 int main(int argc, char *argv[]) {
-	int err; 
+	int err, policy = OVR_SKIP; 
 	struct taskArgsStruct taskAArgs;
+	char tracename[64];
+	
+	/* Overrun policy of the periodic tasks */
+	if(argc > 2 || (argc == 2 && (policy = OverrunParse(argv[1])) < 0)) {
+		printf("Usage: %s [skip|catchup|degrade|abort], the overrun policy (default skip)\n", argv[0]);
+		return -1;
+	}
 	
 	/* Lock memory to prevent paging */
 	mlockall(MCL_CURRENT|MCL_FUTURE); 
 
+	/* Heavy_Work sub-intervals for TASK_WORK_US on this host */
+	printf("Workload calibration: %.3f ns per sub-interval\n\r", WorkloadCalibrate());
+
+	/* Activations are logged to a binary trace, written by a non real-time drainer thread */
+	snprintf(tracename, sizeof(tracename), "%s.trace", argv[0]);
+	TraceInit(&task_a_trace, 1);
+	if(TraceStart(tracename))
+		return -1;
+
 	/* Create RT task */
 	/* Args: descriptor, name, stack size, priority [0..99] and mode (flags for CPU, FPU, joinable ...) */
 	err=rt_task_create(&task_a_desc, "Task a", TASK_STKSZ, TASK_A_PRIO, TASK_MODE);
@@ -77,10 +103,16 @@ int main(int argc, char *argv[]) {
 	/* Start RT task */
 	/* Args: task decriptor, address of function/implementation and argument*/
 	taskAArgs.taskPeriod_ns = TASK_A_PERIOD_NS; 	
+	taskAArgs.trace = &task_a_trace;
+	taskAArgs.min_ita = taskAArgs.max_ita = 0;
+	OverrunInit(&taskAArgs.ovr, policy);
     rt_task_start(&task_a_desc, &task_code, (void *)&taskAArgs);
     
 	/* wait for termination signal */	
 	wait_for_ctrl_c();
+	TraceStop();
+	printf("Time between successive jobs of Task a : min: %ld / max: %ld\n", taskAArgs.min_ita, taskAArgs.max_ita);
+	OverrunPrint(&taskAArgs.ovr, "a");
 
 	return 0;
 		
@@ -94,13 +126,12 @@ void task_code(void *args) {
 	RT_TASK_INFO curtaskinfo;
 	struct taskArgsStruct *taskArgs;
 
-	RTIME ta, last_ta, max_ta = 0;
-	RTIME ita;
-	RTIME min_ta = LLONG_MIN;
+	RTIME ta, last_ta = 0;
+	nstime_t ita, max_ta = 0, min_ta = NSTIME_MAX;	// Inter-activation times (ns)
 	unsigned long overruns;
 	int err;
-	int update = 0;
 	int niter = 0;
+	int jobs;
 
 	/* Get task information */
 	curtask=rt_task_self();
@@ -114,38 +145,41 @@ void task_code(void *args) {
 	for(;;) {
 		err=rt_task_wait_period(&overruns);
 		ta=rt_timer_read();
-		if(err) {
-			printf("task %s overrun!!!\n", curtaskinfo.name);
+		jobs = OverrunCheck(&taskArgs->ovr, err, overruns, NsFromRtime(ta));
+		if(jobs < 0) {
+			printf("task %s wait period error %d!!!\n", curtaskinfo.name, jobs);
 			break;
 		}
+		if(err)
+			TraceEmit(taskArgs->trace, ta, TRACE_OVERRUN, overruns);
+		if(jobs == 0)
+			continue; // Aborted
 		//printf("Task %s activation at time %llu\n", curtaskinfo.name,ta);
 		niter++;
 		
 		if (niter == BOOT_ITER) {
-			max_ta = ta - last_ta;
-			min_ta = ta - last_ta;
-			update = 1;
+			max_ta = NsDiff(NsFromRtime(ta), NsFromRtime(last_ta));
+			min_ta = NsDiff(NsFromRtime(ta), NsFromRtime(last_ta));
 		} else 
 		if (niter > BOOT_ITER) {
-			ita = ta - last_ta;
+			ita = NsDiff(NsFromRtime(ta), NsFromRtime(last_ta));
 			if(ita>max_ta){
 				max_ta = ita;
-				update = 1;
 		
 			}
 			if(ita<min_ta){
 				min_ta = ita;
-				update = 1;
 				
 			}
+			taskArgs->min_ita = min_ta;
+			taskArgs->max_ita = max_ta;
 		}
 
-		if (update){
-			printf("Time between successive jobs of %s : min: %llu / max: %llu\n\n",curtaskinfo.name, min_ta, max_ta);
-			update = 0;
-		}
-		/* Task "load" */
-		Heavy_Work();
+		/* Log the activation (no printf in the real-time loop) */
+		TraceEmit(taskArgs->trace, ta, TRACE_RELEASE, niter > 1 ? ta - last_ta : 0);
+		/* Task "load": the missed jobs too (catchup), reduced (degrade) */
+		while(jobs-- > 0)
+			Heavy_Work(OverrunScale(&taskArgs->ovr));
 		last_ta = ta;
 	}
 	return;
@@ -175,11 +209,9 @@ void wait_for_ctrl_c(void) {
 /* **************************************************************************
  *  Task load implementation. In the case integrates numerically a function
  * **************************************************************************/
-#define f(x) 1/(1+pow(x,2)) /* Define function to integrate*/
-void Heavy_Work(void)
+void Heavy_Work(double scale)
 {
-	float lower, upper, integration=0.0, stepSize, k;
-	int i, subInterval;
+	float integration;
 	
 	RTIME ts, // Function start time
 		  tf; // Function finish time
@@ -189,24 +221,8 @@ void Heavy_Work(void)
 	/* Get start time */
 	ts=rt_timer_read();
 	
-	/* Integration parameters */
-	/*These values can be tunned to cause a desired load*/
-	lower=0;
-	upper=100;
-	subInterval=1000000;
-
-	 /* Calculation */
-	 /* Finding step size */
-	 stepSize = (upper - lower)/subInterval;
-
-	 /* Finding Integration Value */
-	 integration = f(lower) + f(upper);
-	 for(i=1; i<= subInterval-1; i++)
-	 {
-		k = lower + i*stepSize;
-		integration = integration + 2 * f(k);
- 	}
-	integration = integration * stepSize/2;
+	/* Calibrated load (see workload.h) */
+	integration = WorkloadRun(TASK_WORK_US * NS_PER_US * scale);
  	
  	/* Get finish time and show results */
  	if (!first) {
@@ -22,6 +22,12 @@
 #include <alchemy/task.h>
 #include <alchemy/timer.h>
 
+#include "../common/trace.h" // Binary event trace
+#include "../common/nstime.h" // 64-bit ns time arithmetic
+#include "../common/workload.h" // Calibrated execution times
+#include "../common/overrun.h" // Overrun policies
+#include "../common/partition.h" // Task to core assignment
+
 
 #define MS_2_NS(ms)(ms*1000*1000) /* Convert ms to ns */
 #define NS_IN_SEC 1000000000L
@@ -32,6 +38,9 @@
  struct taskArgsStruct {
 	 RTIME taskPeriod_ns;
 	 int some_other_arg;
+	 struct trace_ring *trace;	// Event ring of the task
+	 nstime_t min_ita, max_ita;	// Observed inter-activation times in ns (after BOOT_ITER)
+	 struct overrun ovr;		// Overrun policy and counters
  };
 
 /* *******************
@@ -43,9 +52,20 @@
 #define TASK_A_PRIO 25 	// RT priority [0..99]
 #define TASK_PERIOD_NS MS_2_NS(1000)
 #define BOOT_ITER 10
+#define TASK_WORK_US 20000		// Heavy_Work execution time (us), calibrated at startup
+#define TASK_WCET_NS MS_2_NS(25)	// Declared WCET of Heavy_Work (partitioning)
 RT_TASK task_a_desc; // Task decriptor
 RT_TASK task_b_desc;
 RT_TASK task_c_desc;
+RT_TASK *task_desc[3] = { &task_a_desc, &task_b_desc, &task_c_desc };
+struct trace_ring task_trace[3]; // Task event rings
+
+/* Task set model for the partitioner (partition.h) */
+struct an_task task_model[3] = {
+	{ .name = "Task a", .C = TASK_WCET_NS, .T = TASK_PERIOD_NS, .D = TASK_PERIOD_NS, .prio = TASK_A_PRIO },
+	{ .name = "Task b", .C = TASK_WCET_NS, .T = TASK_PERIOD_NS, .D = TASK_PERIOD_NS, .prio = 10 },
+	{ .name = "Task c", .C = TASK_WCET_NS, .T = TASK_PERIOD_NS, .D = TASK_PERIOD_NS, .prio = 75 },
+};
 
 
 
@@ -54,35 +74,67 @@ RT_TASK task_c_desc;
 * **********************/
 void catch_signal(int sig); 	/* Catches CTRL + C to allow a controlled termination of the application */
 void wait_for_ctrl_c(void);
-void Heavy_Work(void);      	/* Load task */
+void Heavy_Work(double scale);	/* Load task */
 void task_code(void *args); 	/* Periodic Task body */
-int changeAffinity(RT_TASK task1, RT_TASK task2, RT_TASK task3); //Change affinity to CPU0 
+int changeAffinity(RT_TASK *tasks[], struct an_task *model, int n); //Partition the tasks to the cores
 
 
 /* *********************
 * Change Affinity function
 * **********************/
-int changeAffinity(RT_TASK task1, RT_TASK task2, RT_TASK task3){
+int changeAffinity(RT_TASK *tasks[], struct an_task *model, int n){
 	cpu_set_t cpuset;                                       //cpu_set bit mask.
-	CPU_ZERO(&cpuset);                                      //Initialize it all to 0
-	CPU_SET(0,&cpuset);                                     //Set the bit that represents core 0
-	if(rt_task_set_affinity(&task1,&cpuset) || rt_task_set_affinity(&task2,&cpuset) || rt_task_set_affinity(&task3,&cpuset)) {     //Set thread's CPU affinity mask to 0 
-		printf("\n Lock of process to CPU0 failed!!!");
-	return(1);
+	int i, ncores = sysconf(_SC_NPROCESSORS_ONLN);
+
+	/* Worst-fit decreasing with a response time check per core */
+	for(i = 0; i < n; i++)
+		model[i].core = PART_AUTO;
+	if(Partition(model, n, ncores, PART_WFD, AN_PCP)) {
+		printf("\n Task set does not fit in %d cores!!!", ncores);
+		return(1);
+	}
+
+	for(i = 0; i < n; i++) {
+		CPU_ZERO(&cpuset);                                  //Initialize it all to 0
+		CPU_SET(model[i].core, &cpuset);                    //Set the bit of the assigned core
+		if(rt_task_set_affinity(tasks[i], &cpuset)) {
+			printf("\n Lock of %s to CPU%d failed!!!", model[i].name, model[i].core);
+			return(1);
+		}
+		printf("%s on CPU%d\n", model[i].name, model[i].core);
 	}
+	return(0);
 }
 /* ******************
 * Main function
 * *******************/ 
 int main(int argc, char *argv[]) {
-	int err,err2,err3; 
+	int err,err2,err3,policy = OVR_SKIP; 
 	struct taskArgsStruct taskAArgs;
 	struct taskArgsStruct taskBArgs;
 	struct taskArgsStruct taskCArgs;
+	char tracename[64];
+	
+	/* Overrun policy of the periodic tasks */
+	if(argc > 2 || (argc == 2 && (policy = OverrunParse(argv[1])) < 0)) {
+		printf("Usage: %s [skip|catchup|degrade|abort], the overrun policy (default skip)\n", argv[0]);
+		return -1;
+	}
 	
 	/* Lock memory to prevent paging */
 	mlockall(MCL_CURRENT|MCL_FUTURE); 
 
+	/* Heavy_Work sub-intervals for TASK_WORK_US on this host */
+	printf("Workload calibration: %.3f ns per sub-interval\n\r", WorkloadCalibrate());
+
+	/* Activations are logged to a binary trace, written by a non real-time drainer thread */
+	snprintf(tracename, sizeof(tracename), "%s.trace", argv[0]);
+	TraceInit(&task_trace[0], 1);
+	TraceInit(&task_trace[1], 2);
+	TraceInit(&task_trace[2], 3);
+	if(TraceStart(tracename))
+		return -1;
+
 	/* Create RT task */
 	/* Args: descriptor, name, stack size, priority [0..99] and mode (flags for CPU, FPU, joinable ...) */
 	err=rt_task_create(&task_a_desc, "Task a", TASK_STKSZ, TASK_A_PRIO, TASK_MODE);
@@ -110,8 +162,18 @@ int main(int argc, char *argv[]) {
 	taskAArgs.taskPeriod_ns = TASK_PERIOD_NS;
 	taskBArgs.taskPeriod_ns = TASK_PERIOD_NS; 
 	taskCArgs.taskPeriod_ns = TASK_PERIOD_NS;
-
-	changeAffinity(task_a_desc,task_b_desc,task_c_desc);
+	taskAArgs.trace = &task_trace[0];
+	taskBArgs.trace = &task_trace[1];
+	taskCArgs.trace = &task_trace[2];
+	taskAArgs.min_ita = taskAArgs.max_ita = 0;
+	taskBArgs.min_ita = taskBArgs.max_ita = 0;
+	taskCArgs.min_ita = taskCArgs.max_ita = 0;
+	OverrunInit(&taskAArgs.ovr, policy);
+	OverrunInit(&taskBArgs.ovr, policy);
+	OverrunInit(&taskCArgs.ovr, policy);
+
+	if(changeAffinity(task_desc, task_model, 3))
+		return -1;
 
     rt_task_start(&task_a_desc, &task_code, (void *)&taskAArgs);
 	rt_task_start(&task_b_desc, &task_code, (void *)&taskBArgs);
@@ -119,6 +181,13 @@ int main(int argc, char *argv[]) {
     
 	/* wait for termination signal */	
 	wait_for_ctrl_c();
+	TraceStop();
+	printf("Task a | min: %ld / max: %ld\n", taskAArgs.min_ita, taskAArgs.max_ita);
+	printf("Task b | min: %ld / max: %ld\n", taskBArgs.min_ita, taskBArgs.max_ita);
+	printf("Task c | min: %ld / max: %ld\n", taskCArgs.min_ita, taskCArgs.max_ita);
+	OverrunPrint(&taskAArgs.ovr, "a");
+	OverrunPrint(&taskBArgs.ovr, "b");
+	OverrunPrint(&taskCArgs.ovr, "c");
 
 	return 0;
 		
@@ -132,12 +201,12 @@ void task_code(void *args) {
 	RT_TASK_INFO curtaskinfo;
 	struct taskArgsStruct *taskArgs;
 
-	RTIME ta, last_ta, max_ta = 0;
-	RTIME ita, min_ta;
+	RTIME ta, last_ta = 0;
+	nstime_t ita, max_ta = 0, min_ta = NSTIME_MAX;	// Inter-activation times (ns)
 	unsigned long overruns;
 	int err;
-	int update = 0;
 	int niter = 0;
+	int jobs;
 
 	/* Get task information */
 	curtask=rt_task_self();
@@ -151,15 +220,21 @@ void task_code(void *args) {
 	for(;;) {
 		err=rt_task_wait_period(&overruns);
 		ta=rt_timer_read();
-		if(err) {
-			printf("task %s overrun!!!\n", curtaskinfo.name);
+		jobs = OverrunCheck(&taskArgs->ovr, err, overruns, NsFromRtime(ta));
+		if(jobs < 0) {
+			printf("task %s wait period error %d!!!\n", curtaskinfo.name, jobs);
 			break;
 		}
-		printf("%s activation at time %llu", curtaskinfo.name,ta);
+		if(err)
+			TraceEmit(taskArgs->trace, ta, TRACE_OVERRUN, overruns);
+		if(jobs == 0)
+			continue; // Aborted
 		niter++;
 		if( niter == 1) 
 		    last_ta = ta; 
-		ita = ta - last_ta;
+		ita = NsDiff(NsFromRtime(ta), NsFromRtime(last_ta));
+		/* Log the activation (no printf in the real-time loop) */
+		TraceEmit(taskArgs->trace, ta, TRACE_RELEASE, ita);
 		if (niter == BOOT_ITER) {
 			max_ta = ita;
 			min_ta = ita;
@@ -170,13 +245,14 @@ void task_code(void *args) {
 			if(ita<min_ta)
 				min_ta = ita;				
 			
-			printf(" | min: %llu / max: %llu", min_ta, max_ta);
+			taskArgs->min_ita = min_ta;
+			taskArgs->max_ita = max_ta;
 		}
-		printf("\n");
 		
 		
-		/* Task "load" */
-		Heavy_Work();
+		/* Task "load": the missed jobs too (catchup), reduced (degrade) */
+		while(jobs-- > 0)
+			Heavy_Work(OverrunScale(&taskArgs->ovr));
 		
 		last_ta = ta;
 	}
@@ -207,11 +283,9 @@ void wait_for_ctrl_c(void) {
 /* **************************************************************************
  *  Task load implementation. In the case integrates numerically a function
  * **************************************************************************/
-#define f(x) 1/(1+pow(x,2)) /* Define function to integrate*/
-void Heavy_Work(void)
+void Heavy_Work(double scale)
 {
-	float lower, upper, integration=0.0, stepSize, k;
-	int i, subInterval;
+	float integration;
 	
 	RTIME ts, // Function start time
 		  tf; // Function finish time
@@ -221,24 +295,8 @@ void Heavy_Work(void)
 	/* Get start time */
 	ts=rt_timer_read();
 	
-	/* Integration parameters */
-	/*These values can be tunned to cause a desired load*/
-	lower=0;
-	upper=100;
-	subInterval=1020000;
-
-	 /* Calculation */
-	 /* Finding step size */
-	 stepSize = (upper - lower)/subInterval;
-
-	 /* Finding Integration Value */
-	 integration = f(lower) + f(upper);
-	 for(i=1; i<= subInterval-1; i++)
-	 {
-		k = lower + i*stepSize;
-		integration = integration + 2 * f(k);
- 	}
-	integration = integration * stepSize/2;
+	/* Calibrated load (see workload.h) */
+	integration = WorkloadRun(TASK_WORK_US * NS_PER_US * scale);
  	
  	/* Get finish time and show results */
  	if (!first) {
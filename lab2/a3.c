@@ -12,6 +12,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <signal.h>
 #include <math.h>
@@ -23,6 +24,15 @@
 #include <alchemy/timer.h>
 #include <alchemy/sem.h>
 
+#include "../common/trace.h" // Binary event trace
+#include "../common/nstime.h" // 64-bit ns time arithmetic
+#include "../common/workload.h" // Calibrated execution times
+#include "../common/partition.h" // Task to core assignment
+#include "../common/resource.h" // Priority inheritance / ceiling mutexes
+#include "../common/lockfree.h" // Atomic sequence counter
+#include "../common/overrun.h" // Overrun policies
+#include "../common/server.h" // Sporadic / deferrable servers
+
 #define MS_2_NS(ms)(ms*1000*1000) /* Convert ms to ns */
 #define NS_IN_SEC 1000000000L
 
@@ -32,6 +42,12 @@
  struct taskArgsStruct {
 	 RTIME taskPeriod_ns;
 	 int some_other_arg;
+	 struct trace_ring *trace;	// Event ring of the task
+	 nstime_t min_ita, max_ita;	// Observed inter-activation times in ns (after BOOT_ITER)
+	 struct res_user block;		// Blocking on seq_res per job
+	 struct overrun ovr;		// Overrun policy and counters (periodic task)
+	 struct server srv;		// Event queue and budget (sporadic tasks)
+	 RT_SEM arrival;			// Counts the queued events (sporadic tasks)
  };
 
 /* *******************
@@ -43,56 +59,135 @@
 #define TASK_A_PRIO 25 	// RT priority [0..99]
 #define TASK_PERIOD_NS MS_2_NS(1000)
 #define BOOT_ITER 10
+#define TASK_WORK_US 20000		// Heavy_Work execution time (us), calibrated at startup
+#define TASK_CS_US 5000			// Work on seq_number (us), inside the critical section if locked
+#define TASK_WCET_NS MS_2_NS(30)	// Declared WCET of a job (partitioning)
+#define TASK_CS_NS MS_2_NS(6)		// Declared longest critical section (partitioning)
+#define SPORADIC_BURST 3			// Events per job of Task a, for each sporadic task
+#define SRV_BUDGET_NS MS_2_NS(100)	// Execution time of a sporadic task per SRV_PERIOD_NS
+#define SRV_PERIOD_NS TASK_PERIOD_NS
+#define SRV_MIN_IA_NS MS_2_NS(100)	// Minimum time between the jobs of a sporadic task
 
 RT_TASK task_a_desc; // Task decriptor
 RT_TASK task_b_desc;
 RT_TASK task_c_desc;
-RT_SEM sem; //shared semaphore 
+RT_TASK *task_desc[3] = { &task_a_desc, &task_b_desc, &task_c_desc };
+struct taskArgsStruct *sporadic_args[2]; // Event streams of the sporadic tasks, fed by the periodic one
+struct resource seq_res; // Protects seq_number (unless seq_lockfree)
+int seq_lockfree = 1; // seq_number is an atomic counter, no lock
+struct trace_ring task_trace[3]; // Task event rings
+
+/* Task set model for the partitioner (partition.h). With seq_number locked (none|pip|pcp) all the tasks
+ * lock seq_res, so they share a core; lock-free (default) main drops the critical sections.
+ * A served sporadic task is a periodic one of C = SRV_BUDGET_NS and T = SRV_PERIOD_NS (set in main), with a
+ * jitter J = SRV_PERIOD_NS - SRV_BUDGET_NS for the deferrable server */
+struct an_task task_model[3] = {
+	{ .name = "Task a", .C = TASK_WCET_NS, .T = TASK_PERIOD_NS, .D = TASK_PERIOD_NS, .prio = TASK_A_PRIO, .ncs = 1, .cs = {{"seq", TASK_CS_NS}} },
+	{ .name = "Task b", .C = TASK_WCET_NS, .T = TASK_PERIOD_NS, .D = TASK_PERIOD_NS, .prio = 20, .ncs = 1, .cs = {{"seq", TASK_CS_NS}} },
+	{ .name = "Task c", .C = TASK_WCET_NS, .T = TASK_PERIOD_NS, .D = TASK_PERIOD_NS, .prio = 10, .ncs = 1, .cs = {{"seq", TASK_CS_NS}} },
+};
 
 /* ****************
 * Global Variables
 * *****************/
 
-int seq_number = 0; //global variable to the tasks
+struct lf_counter seq_number; //global variable to the tasks
 
 /* *********************
 * Function prototypes
 * **********************/
 void catch_signal(int sig); 	/* Catches CTRL + C to allow a controlled termination of the application */
 void wait_for_ctrl_c(void);
-void Heavy_Work(void);      	/* Load task */
+void Heavy_Work(double scale);	/* Load task */
 void periodic_task_code(void *args); 	/* Periodic Task body */
 void sporadic_task_code(void *args); 	/* Sporadic Task body */
-int changeAffinity(RT_TASK task1, RT_TASK task2, RT_TASK task3); //Change affinity to CPU0 
+int Seq_update(struct res_user *u, int reset);	/* Updates seq_number */
+int changeAffinity(RT_TASK *tasks[], struct an_task *model, int n, int protocol); //Partition the tasks to the cores
 
 
 /* *********************
 * Change Affinity function
 * **********************/
-int changeAffinity(RT_TASK task1, RT_TASK task2, RT_TASK task3){
+int changeAffinity(RT_TASK *tasks[], struct an_task *model, int n, int protocol){
 	cpu_set_t cpuset;                                       //cpu_set bit mask.
-	CPU_ZERO(&cpuset);                                      //Initialize it all to 0
-	CPU_SET(0,&cpuset);                                     //Set the bit that represents core 0
-	if(rt_task_set_affinity(&task1,&cpuset) || rt_task_set_affinity(&task2,&cpuset) || rt_task_set_affinity(&task3,&cpuset)) {     //Set thread's CPU affinity mask to 0 
-		printf("\n Lock of process to CPU0 failed!!!");
-	return(1);
+	int i, ncores = sysconf(_SC_NPROCESSORS_ONLN);
+
+	/* Worst-fit decreasing with a response time check per core */
+	for(i = 0; i < n; i++)
+		model[i].core = PART_AUTO;
+	if(Partition(model, n, ncores, PART_WFD, protocol == RES_PIP ? AN_PIP : AN_PCP)) {
+		printf("\n Task set does not fit in %d cores!!!", ncores);
+		return(1);
 	}
+
+	for(i = 0; i < n; i++) {
+		CPU_ZERO(&cpuset);                                  //Initialize it all to 0
+		CPU_SET(model[i].core, &cpuset);                    //Set the bit of the assigned core
+		if(rt_task_set_affinity(tasks[i], &cpuset)) {
+			printf("\n Lock of %s to CPU%d failed!!!", model[i].name, model[i].core);
+			return(1);
+		}
+		printf("%s on CPU%d\n", model[i].name, model[i].core);
+	}
+	return(0);
 }
 /* ******************
 * Main function
 * *******************/ 
 int main(int argc, char *argv[]) {
-	int err,err2,err3,semaphore; 
+	int err,err2,err3,protocol = RES_PCP,policy = OVR_SKIP,kind = SRV_SPORADIC;
 	struct taskArgsStruct taskAArgs;
 	struct taskArgsStruct taskBArgs;
 	struct taskArgsStruct taskCArgs;
+	char tracename[64];
 
-	//Create Semaphore
-	rt_sem_create(&sem,"semaphore",1,S_FIFO);
+	/* seq_number lock-free (default) or locked with a resource access protocol, overrun policy of Task a,
+	 * server of the sporadic tasks */
+	if(argc >= 2 && strcmp(argv[1], "lockfree")) {
+		seq_lockfree = 0;
+		protocol = ResParse(argv[1]);
+	}
+	if(argc >= 3)
+		policy = OverrunParse(argv[2]);
+	if(argc == 4)
+		kind = ServerParse(argv[3]);
+	if(argc > 4 || protocol < 0 || policy < 0 || kind < 0) {
+		printf("Usage: %s [lockfree|none|pip|pcp] [skip|catchup|degrade|abort] [sporadic|deferrable|none], an atomic "
+			"seq_number (default) or the protocol of its mutex, the overrun policy (default skip) and the server of "
+			"the sporadic tasks (default sporadic)\n", argv[0]);
+		return -1;
+	}
+	if(seq_lockfree)
+		task_model[0].ncs = task_model[1].ncs = task_model[2].ncs = 0; // No blocking
+	if(kind == SRV_NONE)
+		task_model[1].C = task_model[2].C = SPORADIC_BURST * TASK_WCET_NS; // A whole burst per period
+	else {
+		task_model[1].C = task_model[2].C = SRV_BUDGET_NS;
+		task_model[1].T = task_model[1].D = task_model[2].T = task_model[2].D = SRV_PERIOD_NS;
+		if(kind == SRV_DEFERRABLE) // Two budgets back-to-back across a period boundary (server.h)
+			task_model[1].J = task_model[2].J = SRV_PERIOD_NS - SRV_BUDGET_NS;
+	}
 
 	/* Lock memory to prevent paging */
 	mlockall(MCL_CURRENT|MCL_FUTURE); 
 
+	//Create the event semaphores and, if locked, the seq_number mutex (ceiling: Task a, its highest priority user)
+	rt_sem_create(&taskBArgs.arrival,"arrival b",0,S_FIFO);
+	rt_sem_create(&taskCArgs.arrival,"arrival c",0,S_FIFO);
+	if(!seq_lockfree && ResInit(&seq_res, "seq", protocol, TASK_A_PRIO))
+		return -1;
+
+	/* Heavy_Work sub-intervals for TASK_WORK_US on this host */
+	printf("Workload calibration: %.3f ns per sub-interval\n\r", WorkloadCalibrate());
+
+	/* Activations are logged to a binary trace, written by a non real-time drainer thread */
+	snprintf(tracename, sizeof(tracename), "%s.trace", argv[0]);
+	TraceInit(&task_trace[0], 1);
+	TraceInit(&task_trace[1], 2);
+	TraceInit(&task_trace[2], 3);
+	if(TraceStart(tracename))
+		return -1;
+
 	/* Create RT task */
 	/* Args: descriptor, name, stack size, priority [0..99] and mode (flags for CPU, FPU, joinable ...) */
 	err=rt_task_create(&task_a_desc, "Task a", TASK_STKSZ, TASK_A_PRIO, TASK_MODE);
@@ -120,8 +215,23 @@ int main(int argc, char *argv[]) {
 	taskAArgs.taskPeriod_ns = TASK_PERIOD_NS;
 	taskBArgs.taskPeriod_ns = TASK_PERIOD_NS; 
 	taskCArgs.taskPeriod_ns = TASK_PERIOD_NS; 
-
-	changeAffinity(task_a_desc,task_b_desc,task_c_desc);
+	taskAArgs.trace = &task_trace[0];
+	taskBArgs.trace = &task_trace[1];
+	taskCArgs.trace = &task_trace[2];
+	taskAArgs.min_ita = taskAArgs.max_ita = 0;
+	taskBArgs.min_ita = taskBArgs.max_ita = 0;
+	taskCArgs.min_ita = taskCArgs.max_ita = 0;
+	ResUserInit(&taskAArgs.block);
+	OverrunInit(&taskAArgs.ovr, policy);
+	ResUserInit(&taskBArgs.block);
+	ResUserInit(&taskCArgs.block);
+	ServerInit(&taskBArgs.srv, kind, SRV_BUDGET_NS, SRV_PERIOD_NS, SRV_MIN_IA_NS, NsFromRtime(rt_timer_read()));
+	ServerInit(&taskCArgs.srv, kind, SRV_BUDGET_NS, SRV_PERIOD_NS, SRV_MIN_IA_NS, NsFromRtime(rt_timer_read()));
+	sporadic_args[0] = &taskBArgs;
+	sporadic_args[1] = &taskCArgs;
+
+	if(changeAffinity(task_desc, task_model, 3, protocol))
+		return -1;
 
     rt_task_start(&task_a_desc, &periodic_task_code, (void *)&taskAArgs);
 	rt_task_start(&task_b_desc, &sporadic_task_code, (void *)&taskBArgs);
@@ -129,6 +239,18 @@ int main(int argc, char *argv[]) {
     
 	/* wait for termination signal */	
 	wait_for_ctrl_c();
+	TraceStop();
+	printf("Task a | min: %ld / max: %ld\n", taskAArgs.min_ita, taskAArgs.max_ita);
+	printf("Task b | min: %ld / max: %ld\n", taskBArgs.min_ita, taskBArgs.max_ita);
+	printf("Task c | min: %ld / max: %ld\n", taskCArgs.min_ita, taskCArgs.max_ita);
+	OverrunPrint(&taskAArgs.ovr, "a");
+	if(!seq_lockfree)
+		ResPrint(&seq_res);
+	ResUserPrint(&taskAArgs.block, "Task a");
+	ResUserPrint(&taskBArgs.block, "Task b");
+	ResUserPrint(&taskCArgs.block, "Task c");
+	ServerPrint(&taskBArgs.srv, "Task b");
+	ServerPrint(&taskCArgs.srv, "Task c");
 
 	return 0;
 		
@@ -142,13 +264,12 @@ void periodic_task_code(void *args) {
 	RT_TASK_INFO curtaskinfo;
 	struct taskArgsStruct *taskArgs;
 
-	RTIME ta, last_ta, max_ta = 0;
-	RTIME ita;
-	RTIME min_ta = LLONG_MIN;
+	RTIME ta, last_ta = 0;
+	nstime_t ita, max_ta = 0, min_ta = NSTIME_MAX;	// Inter-activation times (ns)
 	unsigned long overruns;
 	int err;
-	int update = 0;
 	int niter = 0;
+	int seq, jobs, i, k;
 
 	/* Get task information */
 	curtask=rt_task_self();
@@ -160,24 +281,30 @@ void periodic_task_code(void *args) {
 	/* Set task as periodic */
 	err=rt_task_set_periodic(NULL, TM_NOW, taskArgs->taskPeriod_ns);
 	for(;;) {
-		rt_sem_p(&sem,TM_INFINITE);
 		err=rt_task_wait_period(&overruns);
 		ta=rt_timer_read();
-		if(err) {
-			printf("task %s overrun!!!\n", curtaskinfo.name);
+		jobs = OverrunCheck(&taskArgs->ovr, err, overruns, NsFromRtime(ta));
+		if(jobs < 0) {
+			printf("task %s wait period error %d!!!\n", curtaskinfo.name, jobs);
 			break;
 		}
-		seq_number=1;
-		printf("%s activation at time %llu with seq number: %d", curtaskinfo.name,ta,seq_number);
+		if(err)
+			TraceEmit(taskArgs->trace, ta, TRACE_OVERRUN, overruns);
+		if(jobs == 0)
+			continue; // Aborted
+		seq = Seq_update(&taskArgs->block, 1);
+		/* Log the activation (no printf in the real-time loop) */
+		TraceEmit(taskArgs->trace, ta, TRACE_RELEASE, niter > 0 ? ta - last_ta : 0);
+		TraceEmit(taskArgs->trace, ta, TRACE_SEQ, seq);
 		//printf("Task %s seq number: %d\n", curtaskinfo.name,seq_number);
 		niter++;
 		
 		if (niter == BOOT_ITER) {
-			max_ta = ta - last_ta;
-			min_ta = ta - last_ta;
+			max_ta = NsDiff(NsFromRtime(ta), NsFromRtime(last_ta));
+			min_ta = NsDiff(NsFromRtime(ta), NsFromRtime(last_ta));
 		} else 
 		if (niter > BOOT_ITER) {
-			ita = ta - last_ta;
+			ita = NsDiff(NsFromRtime(ta), NsFromRtime(last_ta));
 			if(ita>max_ta){
 				max_ta = ita;
 
@@ -186,13 +313,19 @@ void periodic_task_code(void *args) {
 				min_ta = ita;
 
 			}
-			printf(" | min: %llu / max: %llu", min_ta, max_ta);
+			taskArgs->min_ita = min_ta;
+			taskArgs->max_ita = max_ta;
 		}
-		printf("\n");
 
-		/* Task "load" */
-		Heavy_Work();
-		rt_sem_v(&sem);
+		/* Task "load" (the missed jobs too with catchup, reduced with degrade), then a burst of events
+		 * for each sporadic task (dropped if its queue is full) */
+		while(jobs-- > 0)
+			Heavy_Work(OverrunScale(&taskArgs->ovr));
+		ResJobEnd(&taskArgs->block);
+		for(i = 0; i < 2; i++)
+			for(k = 0; k < SPORADIC_BURST; k++)
+				if(!ServerArrive(&sporadic_args[i]->srv, NsFromRtime(rt_timer_read())))
+					rt_sem_v(&sporadic_args[i]->arrival);
 		last_ta = ta;
 	}
 	return;
@@ -205,13 +338,12 @@ void sporadic_task_code(void *args) {
 	RT_TASK_INFO curtaskinfo;
 	struct taskArgsStruct *taskArgs;
 
-	RTIME ta, last_ta, max_ta = 0;
-	RTIME ita;
-	RTIME min_ta = LLONG_MAX;
-	unsigned long overruns;
-	int err;
-	int update = 0;
+	RTIME ta, last_ta = 0;
+	nstime_t ita, max_ta = 0, min_ta = NSTIME_MAX;	// Inter-activation times (ns)
+	nstime_t arrival, retry;
+	RTIME xtime;
 	int niter = 0;
+	int seq;
 
 	/* Get task information */
 	curtask=rt_task_self();
@@ -220,20 +352,29 @@ void sporadic_task_code(void *args) {
 	printf("Task %s init, period:%llu\n", curtaskinfo.name, taskArgs->taskPeriod_ns);
 
 	for(;;) {
-		rt_sem_p(&sem,TM_INFINITE);
+		/* Oldest queued event, started when the server has the budget for a job and min_ia passed */
+		rt_sem_p(&taskArgs->arrival,TM_INFINITE);
+		if(ServerNext(&taskArgs->srv, &arrival))
+			continue;
+		while((retry = ServerAdmit(&taskArgs->srv, TASK_WCET_NS, NsFromRtime(rt_timer_read()))) != 0)
+			rt_task_sleep_until(NsToRtime(retry));
+		rt_task_inquire(NULL, &curtaskinfo);
+		xtime = curtaskinfo.stat.xtime;
 		ta=rt_timer_read();
-		seq_number++;
-		printf("%s activation at time %llu with seq number: %d", curtaskinfo.name,ta,seq_number);
+		seq = Seq_update(&taskArgs->block, 0);
+		/* Log the activation (no printf in the real-time loop) */
+		TraceEmit(taskArgs->trace, ta, TRACE_RELEASE, niter > 0 ? ta - last_ta : 0);
+		TraceEmit(taskArgs->trace, ta, TRACE_SEQ, seq);
 		niter++;
 		//printf("Task %s seq number: %d\n", curtaskinfo.name,seq_number);
 		
 		if (niter == BOOT_ITER) {
-			max_ta = ta - last_ta;
-			min_ta = ta - last_ta;
+			max_ta = NsDiff(NsFromRtime(ta), NsFromRtime(last_ta));
+			min_ta = NsDiff(NsFromRtime(ta), NsFromRtime(last_ta));
 
 		} else 
 		if (niter > BOOT_ITER) {
-			ita = ta - last_ta;
+			ita = NsDiff(NsFromRtime(ta), NsFromRtime(last_ta));
 			if(ita>max_ta){
 				max_ta = ita;
 
@@ -242,19 +383,44 @@ void sporadic_task_code(void *args) {
 				min_ta = ita;
 				
 			}
-			printf(" | min: %llu / max: %llu", min_ta, max_ta);
+			taskArgs->min_ita = min_ta;
+			taskArgs->max_ita = max_ta;
 		}
-		printf("\n");
 
 		/* Task "load" */
-		Heavy_Work();
-		rt_sem_v(&sem);
+		Heavy_Work(1);
+		ResJobEnd(&taskArgs->block);
+		rt_task_inquire(NULL, &curtaskinfo);
+		ServerDone(&taskArgs->srv, arrival, NsFromRtime(ta), NsFromRtime(rt_timer_read()),
+			NsFromRtime(curtaskinfo.stat.xtime - xtime));
 		last_ta = ta;
 	}
 	return;
 }
 
 
+/* **************************************************************************
+ *  seq_number update: reset to 1 or increment. Returns the new value.
+ *  Lock-free, or a critical section only around it, never across the wait
+ *  for the period
+ * **************************************************************************/
+int Seq_update(struct res_user *u, int reset)
+{
+	int seq;
+
+	if(!seq_lockfree)
+		ResLock(&seq_res, u);
+	if(reset) {
+		LfCounterSet(&seq_number, 1);
+		seq = 1;
+	} else
+		seq = LfCounterNext(&seq_number);
+	WorkloadRun(TASK_CS_US * NS_PER_US);
+	if(!seq_lockfree)
+		ResUnlock(&seq_res);
+	return seq;
+}
+
 /* **************************************************************************
  *  Catch control+c to allow a controlled termination
  * **************************************************************************/
@@ -278,11 +444,9 @@ void wait_for_ctrl_c(void) {
 /* **************************************************************************
  *  Task load implementation. In the case integrates numerically a function
  * **************************************************************************/
-#define f(x) 1/(1+pow(x,2)) /* Define function to integrate*/
-void Heavy_Work(void)
+void Heavy_Work(double scale)
 {
-	float lower, upper, integration=0.0, stepSize, k;
-	int i, subInterval;
+	float integration;
 	
 	RTIME ts, // Function start time
 		  tf; // Function finish time
@@ -292,24 +456,8 @@ void Heavy_Work(void)
 	/* Get start time */
 	ts=rt_timer_read();
 	
-	/* Integration parameters */
-	/*These values can be tunned to cause a desired load*/
-	lower=0;
-	upper=100;
-	subInterval=1000000;
-
-	 /* Calculation */
-	 /* Finding step size */
-	 stepSize = (upper - lower)/subInterval;
-
-	 /* Finding Integration Value */
-	 integration = f(lower) + f(upper);
-	 for(i=1; i<= subInterval-1; i++)
-	 {
-		k = lower + i*stepSize;
-		integration = integration + 2 * f(k);
- 	}
-	integration = integration * stepSize/2;
+	/* Calibrated load (see workload.h) */
+	integration = WorkloadRun(TASK_WORK_US * NS_PER_US * scale);
  	
  	/* Get finish time and show results */
  	if (!first) {
@@ -0,0 +1,153 @@
+/* ************************************************************
+* Xenomai - release jitter benchmark
+*
+* A periodic task at high priority measures, at every release, the
+* latency from the release point to its first instruction and the
+* error of the inter-activation time. The same source builds against
+* Cobalt (make jitter) and against the POSIX stand-in of alchemy
+* (make POSIX=1 jitter-posix), so the two can be compared on the same
+* host: make compare
+************************************************************** */
+/* ************************************************************
+* Miguel Cabral 93091
+* Diogo Vicente 93262
+************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <sys/mman.h> // For mlockall
+
+// Xenomai API (former Native API)
+#include <alchemy/task.h>
+#include <alchemy/timer.h>
+#include <alchemy/sem.h>
+
+#include "../common/hist.h" // Latency histograms
+#include "../common/nstime.h" // 64-bit ns time arithmetic
+
+#ifdef ALCHEMY_POSIX
+#define BACKEND "POSIX stand-in"
+#else
+#define BACKEND "Cobalt"
+#endif
+
+/* *******************
+ * Task attributes
+ * *******************/
+#define TASK_MODE 0  	// No flags
+#define TASK_STKSZ 0 	// Default stack size
+#define TASK_PRIO 90 	// RT priority [0..99]
+
+#define PERIOD_US 1000		// Default period
+#define DURATION_S 10		// Default duration
+#define BOOT_ITER 100		// Releases not recorded (warm-up)
+#define START_DELAY_NS (100 * NS_PER_MS)	// First release point, from the start of the task
+
+/* *****************************************************
+ * Task arguments and results
+ * *****************************************************/
+struct jitterArgs {
+	RTIME period;				// ns
+	unsigned long releases;		// Releases to run
+	unsigned long overruns;		// Waits that reported missed releases
+	unsigned long missed;		// Missed releases
+	int error;					// Error of the wait, 0 if none
+	struct hist latency;		// Release point to task running (ns)
+	struct hist ita_error;		// |inter-activation time - period| (ns)
+};
+
+RT_TASK task_desc;
+RT_SEM done; // Signaled by the task at the end
+
+void jitter_task(void *args);
+
+/* ******************
+* Main function
+* *******************/
+int main(int argc, char *argv[]) {
+	struct jitterArgs j;
+	long period_us = PERIOD_US, duration_s = DURATION_S;
+	int err;
+
+	if(argc >= 2)
+		period_us = atol(argv[1]);
+	if(argc >= 3)
+		duration_s = atol(argv[2]);
+	if(argc > 3 || period_us <= 0 || duration_s <= 0) {
+		printf("Usage: %s [PERIOD_US] [SECONDS], the period of the task (default %d us) and the duration "
+			"(default %d s)\n", argv[0], PERIOD_US, DURATION_S);
+		return -1;
+	}
+
+	/* Lock memory to prevent paging */
+	mlockall(MCL_CURRENT|MCL_FUTURE);
+
+	j.period = (RTIME) period_us * NS_PER_US;
+	j.releases = (unsigned long) (duration_s * NS_PER_SEC / j.period) + BOOT_ITER;
+	j.overruns = j.missed = 0;
+	j.error = 0;
+	HistInit(&j.latency);
+	HistInit(&j.ita_error);
+
+	rt_sem_create(&done, "done", 0, S_FIFO);
+	err = rt_task_create(&task_desc, "jitter", TASK_STKSZ, TASK_PRIO, TASK_MODE);
+	if(!err)
+		err = rt_task_start(&task_desc, &jitter_task, (void *)&j);
+	if(err) {
+		printf("Error starting the task (error code = %d)\n", err);
+		return err;
+	}
+	printf("%s: period %ld us for %ld s, priority %d\n", BACKEND, period_us, duration_s, TASK_PRIO);
+
+	rt_sem_p(&done, TM_INFINITE);
+	if(j.error)
+		printf("Wait period error %d\n", j.error);
+	printf("Backend: %s / period: %llu ns / releases: %lu / overruns: %lu / missed releases: %lu\n", BACKEND,
+		j.period, j.releases - BOOT_ITER, j.overruns, j.missed);
+	HistPrint(&j.latency, "Release latency");
+	HistPrint(&j.ita_error, "Inter-activation error");
+	printf("%s: latency p99 %lu ns / max %lu ns, inter-activation error p99 %lu ns / max %lu ns\n", BACKEND,
+		HistPercentile(&j.latency, 99), j.latency.max, HistPercentile(&j.ita_error, 99), j.ita_error.max);
+
+	return 0;
+}
+
+/* ***********************************
+* Task body implementation
+* *************************************/
+void jitter_task(void *args) {
+	struct jitterArgs *j = (struct jitterArgs *) args;
+	RTIME release, now, last = 0;
+	unsigned long overruns, i;
+	nstime_t ita;
+	int err;
+
+	/* Absolute first release point: the same on Cobalt and on the stand-in (TM_NOW is not) */
+	release = rt_timer_read() + START_DELAY_NS;
+	rt_task_set_periodic(NULL, release, j->period);
+
+	for(i = 0; i < j->releases; i++) {
+		err = rt_task_wait_period(&overruns);
+		now = rt_timer_read();
+		if(err == -ETIMEDOUT) {
+			/* Resumed at the last of the missed release points */
+			j->overruns++;
+			j->missed += overruns;
+			release += overruns * j->period;
+		} else if(err) {
+			j->error = err;
+			break;
+		}
+
+		if(i >= BOOT_ITER) {
+			HistRecord(&j->latency, NsSubSat(NsFromRtime(now), NsFromRtime(release)));
+			ita = NsDiff(NsFromRtime(now), NsFromRtime(last)) - (nstime_t) j->period;
+			HistRecord(&j->ita_error, ita < 0 ? -ita : ita);
+		}
+		last = now;
+		release += j->period;
+	}
+	rt_sem_v(&done);
+}
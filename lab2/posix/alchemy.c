@@ -0,0 +1,287 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * POSIX stand-in for the Xenomai alchemy API
+ *
+ * Implements the subset of alchemy used by lab2 over pthreads,
+ * SCHED_FIFO and clock_nanosleep, so the lab2 programs build and run
+ * on a stock Linux host (make POSIX=1):
+ *  - tasks: a task is a pthread with its priority as SCHED_FIFO
+ *    priority (0: SCHED_OTHER), created by rt_task_start(). The
+ *    affinity can be set before or after the start. Without the
+ *    privilege for SCHED_FIFO (EPERM) it runs as SCHED_OTHER, with a
+ *    warning, so the programs still run on CI hosts.
+ *  - periodic tasks: rt_task_set_periodic() sets the first release at
+ *    idate (TM_NOW: one period from now). rt_task_wait_period() sleeps
+ *    until the next release point with clock_nanosleep(TIMER_ABSTIME).
+ *    If the task calls it one or more whole periods late, the missed
+ *    release points are counted in *overruns and it returns -ETIMEDOUT
+ *    immediately, resynchronized to the last release point, as Cobalt
+ *    does. rt_task_sleep_until() is also a clock_nanosleep(TIMER_ABSTIME).
+ *  - semaphores: see sem.h. Only S_FIFO: the glibc condition variable
+ *    wakes its waiters in arrival order, not by priority, so S_PRIO
+ *    (and S_PULSE) return -EINVAL.
+ * Time is CLOCK_MONOTONIC in ns. Latencies are those of the host kernel
+ * (PREEMPT_RT or not), not of Cobalt.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <alchemy/task.h>
+#include <alchemy/timer.h>
+#include <alchemy/sem.h>
+
+static __thread RT_TASK *current;	// Task of the calling thread, NULL for main()
+
+/* ***********************************************
+* Timer
+* ***********************************************/
+RTIME rt_timer_read(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (RTIME) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void TimespecFromRtime(struct timespec *ts, RTIME t)
+{
+	ts->tv_sec = t / 1000000000ULL;
+	ts->tv_nsec = t % 1000000000ULL;
+}
+
+/* ***********************************************
+* Tasks
+* ***********************************************/
+int rt_task_create(RT_TASK *task, const char *name, int stksize, int prio, int mode)
+{
+	if(prio < 0 || prio > 99)
+		return -EINVAL;
+	memset(task, 0, sizeof(*task));
+	snprintf(task->name, XNOBJECT_NAME_LEN, "%s", name != NULL ? name : "");
+	task->prio = prio;
+	task->mode = mode;
+	task->stksize = stksize;
+	return 0;
+}
+
+static void *TaskEntry(void *arg)
+{
+	RT_TASK *task = (RT_TASK *) arg;
+
+	current = task;
+	task->pid = syscall(SYS_gettid);
+	task->entry(task->arg);
+	return NULL;
+}
+
+int rt_task_start(RT_TASK *task, void (*entry)(void *arg), void *arg)
+{
+	struct sched_param parm;
+	pthread_attr_t attr;
+	int err;
+
+	if(task->started)
+		return -EBUSY;
+	task->entry = entry;
+	task->arg = arg;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	parm.sched_priority = task->prio;
+	pthread_attr_setschedpolicy(&attr, task->prio > 0 ? SCHED_FIFO : SCHED_OTHER);
+	pthread_attr_setschedparam(&attr, &parm);
+	if(task->pinned)
+		pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &task->affinity);
+	if(task->stksize > 0)
+		pthread_attr_setstacksize(&attr, task->stksize);
+	err = pthread_create(&task->thread, &attr, TaskEntry, task);
+	if(err == EPERM && task->prio > 0) {
+		fprintf(stderr, "%s: no permission for SCHED_FIFO, running as SCHED_OTHER\n", task->name);
+		parm.sched_priority = 0;
+		pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+		pthread_attr_setschedparam(&attr, &parm);
+		err = pthread_create(&task->thread, &attr, TaskEntry, task);
+	}
+	pthread_attr_destroy(&attr);
+	if(err)
+		return -err;
+	task->started = 1;
+	return 0;
+}
+
+RT_TASK *rt_task_self(void)
+{
+	return current;
+}
+
+int rt_task_inquire(RT_TASK *task, RT_TASK_INFO *info)
+{
+	struct timespec ts;
+	clockid_t cid;
+
+	if(task == NULL)
+		task = current;
+	memset(info, 0, sizeof(*info));
+	if(task == NULL) {
+		/* main() is not a task: report it as a non real-time one */
+		strcpy(info->name, "main");
+		info->pid = getpid();
+		return 0;
+	}
+	info->prio = task->prio;
+	info->pid = task->pid;
+	strcpy(info->name, task->name);
+	if(task->started && !pthread_getcpuclockid(task->thread, &cid) && !clock_gettime(cid, &ts))
+		info->stat.xtime = (RTIME) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	return 0;
+}
+
+int rt_task_set_affinity(RT_TASK *task, const cpu_set_t *cpus)
+{
+	if(task == NULL)
+		task = current;
+	if(task == NULL)
+		return -EPERM;
+	task->affinity = *cpus;
+	task->pinned = 1;
+	if(task->started)
+		return -pthread_setaffinity_np(task->thread, sizeof(cpu_set_t), cpus);
+	return 0;
+}
+
+int rt_task_set_periodic(RT_TASK *task, RTIME idate, RTIME period)
+{
+	if(task == NULL)
+		task = current;
+	if(task == NULL)
+		return -EPERM;
+	task->period = period;
+	task->next = idate == TM_NOW ? rt_timer_read() + period : idate;
+	return 0;
+}
+
+int rt_task_wait_period(unsigned long *overruns_r)
+{
+	RT_TASK *task = current;
+	struct timespec ts;
+	RTIME now, points;
+
+	if(task == NULL || task->period == 0)
+		return -EWOULDBLOCK;
+
+	TimespecFromRtime(&ts, task->next);
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+
+	/* Release points elapsed since the previous wait: more than one is an overrun */
+	now = rt_timer_read();
+	points = now >= task->next ? (now - task->next) / task->period + 1 : 1;
+	task->next += points * task->period;
+	if(overruns_r != NULL)
+		*overruns_r = points - 1;
+	return points > 1 ? -ETIMEDOUT : 0;
+}
+
+// Sleeps until the absolute time date (TM_INFINITE: forever)
+int rt_task_sleep_until(RTIME date)
+{
+	struct timespec ts;
+
+	if(current == NULL)
+		return -EPERM;
+	if(date == TM_INFINITE) {
+		for(;;)
+			pause();
+	}
+	TimespecFromRtime(&ts, date);
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+	return 0;
+}
+
+/* ***********************************************
+* Semaphores
+* ***********************************************/
+int rt_sem_create(RT_SEM *sem, const char *name, unsigned long icount, int mode)
+{
+	pthread_condattr_t cattr;
+
+	if(mode & (S_PRIO | S_PULSE))
+		return -EINVAL; // Not supported
+	sem->count = icount;
+	sem->gen = 0;
+	sem->mode = mode;
+	pthread_mutex_init(&sem->lock, NULL);
+	pthread_condattr_init(&cattr);
+	pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+	pthread_cond_init(&sem->cv, &cattr);
+	pthread_condattr_destroy(&cattr);
+	return 0;
+}
+
+int rt_sem_delete(RT_SEM *sem)
+{
+	pthread_cond_destroy(&sem->cv);
+	pthread_mutex_destroy(&sem->lock);
+	return 0;
+}
+
+// timeout: relative (ns), TM_INFINITE or TM_NONBLOCK
+int rt_sem_p(RT_SEM *sem, RTIME timeout)
+{
+	struct timespec abs;
+	unsigned long gen;
+	int err = 0;
+
+	if(timeout != TM_INFINITE && timeout != TM_NONBLOCK)
+		TimespecFromRtime(&abs, rt_timer_read() + timeout);
+
+	pthread_mutex_lock(&sem->lock);
+	gen = sem->gen;
+	while(sem->count == 0 && sem->gen == gen) {
+		if(timeout == TM_NONBLOCK) {
+			err = -EWOULDBLOCK;
+			break;
+		}
+		if(timeout == TM_INFINITE)
+			pthread_cond_wait(&sem->cv, &sem->lock);
+		else if(pthread_cond_timedwait(&sem->cv, &sem->lock, &abs) == ETIMEDOUT
+				&& sem->count == 0 && sem->gen == gen) {
+			err = -ETIMEDOUT;
+			break;
+		}
+	}
+	/* Released by a broadcast: the count is not consumed */
+	if(!err && sem->gen == gen)
+		sem->count--;
+	pthread_mutex_unlock(&sem->lock);
+	return err;
+}
+
+int rt_sem_v(RT_SEM *sem)
+{
+	pthread_mutex_lock(&sem->lock);
+	sem->count++;
+	pthread_cond_signal(&sem->cv);
+	pthread_mutex_unlock(&sem->lock);
+	return 0;
+}
+
+int rt_sem_broadcast(RT_SEM *sem)
+{
+	pthread_mutex_lock(&sem->lock);
+	sem->gen++;
+	pthread_cond_broadcast(&sem->cv);
+	pthread_mutex_unlock(&sem->lock);
+	return 0;
+}
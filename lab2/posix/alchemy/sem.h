@@ -0,0 +1,39 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * POSIX stand-in for the Xenomai alchemy API: counting semaphores
+ *
+ * A mutex, a condition variable and a count. rt_sem_broadcast() wakes
+ * every waiter without changing the count, as in alchemy.
+ * See alchemy.c for the behavior of the stand-in.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef _POSIX_ALCHEMY_SEM_H
+#define _POSIX_ALCHEMY_SEM_H
+
+#include <pthread.h>
+
+#include "timer.h"
+
+#define S_FIFO 0x0		// Waiters queued in arrival order
+#define S_PRIO 0x1		// Not supported (waiters queued by priority)
+#define S_PULSE 0x2		// Not supported
+
+typedef struct rt_sem {
+	pthread_mutex_t lock;
+	pthread_cond_t cv;
+	unsigned long count;
+	unsigned long gen;		// Broadcasts so far
+	int mode;
+} RT_SEM;
+
+int rt_sem_create(RT_SEM *sem, const char *name, unsigned long icount, int mode);
+int rt_sem_delete(RT_SEM *sem);
+int rt_sem_p(RT_SEM *sem, RTIME timeout);
+int rt_sem_v(RT_SEM *sem);
+int rt_sem_broadcast(RT_SEM *sem);
+
+#endif
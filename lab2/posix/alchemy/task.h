@@ -0,0 +1,60 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * POSIX stand-in for the Xenomai alchemy API: task services
+ *
+ * Each RT_TASK is a SCHED_FIFO pthread, created by rt_task_start().
+ * Calls return 0 or a negative errno, like alchemy.
+ * See alchemy.c for the behavior of the stand-in.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef _POSIX_ALCHEMY_TASK_H
+#define _POSIX_ALCHEMY_TASK_H
+
+#include <sched.h> // cpu_set_t, requires _GNU_SOURCE
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "timer.h"
+
+#define ALCHEMY_POSIX 1		// Built against the stand-in, not Cobalt
+#define XNOBJECT_NAME_LEN 32
+
+typedef struct rt_task {
+	pthread_t thread;
+	char name[XNOBJECT_NAME_LEN];
+	int prio;					// SCHED_FIFO priority [0..99], 0 runs as SCHED_OTHER
+	int mode;
+	int stksize;				// 0: default
+	int started;
+	pid_t pid;					// Thread id, once started
+	cpu_set_t affinity;
+	int pinned;					// affinity set before the start
+	void (*entry)(void *arg);
+	void *arg;
+	RTIME period;				// 0 if not periodic
+	RTIME next;					// Next release point (absolute ns)
+} RT_TASK;
+
+typedef struct rt_task_info {
+	int prio;
+	struct {
+		RTIME xtime;			// Execution time (ns), from the thread CPU clock
+	} stat;
+	char name[XNOBJECT_NAME_LEN];
+	pid_t pid;
+} RT_TASK_INFO;
+
+int rt_task_create(RT_TASK *task, const char *name, int stksize, int prio, int mode);
+int rt_task_start(RT_TASK *task, void (*entry)(void *arg), void *arg);
+RT_TASK *rt_task_self(void);
+int rt_task_inquire(RT_TASK *task, RT_TASK_INFO *info);
+int rt_task_set_affinity(RT_TASK *task, const cpu_set_t *cpus);
+int rt_task_set_periodic(RT_TASK *task, RTIME idate, RTIME period);
+int rt_task_wait_period(unsigned long *overruns_r);
+int rt_task_sleep_until(RTIME date);
+
+#endif
@@ -0,0 +1,25 @@
+/******************************************************************
+ * DETI/UA/IT - Real-Time Operating Systems course
+ *
+ * POSIX stand-in for the Xenomai alchemy API: timer services
+ *
+ * Time is CLOCK_MONOTONIC in ns, as on Cobalt (one tick = 1 ns).
+ * See alchemy.c for the behavior of the stand-in.
+ *
+ * Miguel Cabral - 93091
+ * Diogo Vicente - 93262
+ *****************************************************************/
+
+#ifndef _POSIX_ALCHEMY_TIMER_H
+#define _POSIX_ALCHEMY_TIMER_H
+
+typedef unsigned long long RTIME;	// Absolute or relative time (ns)
+typedef long long SRTIME;			// Signed relative time (ns)
+
+#define TM_INFINITE 0				// No timeout
+#define TM_NOW 0					// Start now (rt_task_set_periodic)
+#define TM_NONBLOCK ((RTIME) -1)	// Do not wait
+
+RTIME rt_timer_read(void);
+
+#endif
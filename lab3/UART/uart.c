@@ -0,0 +1,305 @@
+/* 
+ * File:   uart.c
+ * Author: Paulo Pedreiras
+ *
+ * Created on Jan 28, 2019
+ * MPLAB X IDE v5.10 + XC32 v2.15
+ *
+ * Target: Digilent chipKIT MAx32 board 
+ * 
+ * Overview:
+ *          Set of functions to handle the UART       
+ 
+ * Notes: Partially based on the bootloader code from Microchip
+ * 
+ * Revisions:
+ *      2017-10-25: initial release
+ *      2019-01-28: updated to MPLAB X IDE v5.\0 + XC32 v2.15
+ */
+
+
+#include <xc.h>
+#include <sys/attribs.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "../../common/lockfree.h"
+#include "uart.h"
+
+static struct lf_ring txRing;           // Tasks -> TX interrupt (single consumer)
+static uint8_t txBuf[UART_TX_BUF];
+static int txPolicy = UART_TX_DROP;
+static struct uart_tx_stats txStats;
+
+/********************************************************************
+* Function: 	UartInit()
+* Precondition: 
+* Input: 		PB Clock and baudrate
+* Returns:      UART_SUCCESS if Ok.
+*               UARTX_XXX error codes in case of failure (see uart.h)
+* Side Effects:	Takes control of U1A TX and RX pins
+* Overview:     Initializes UART.
+*		
+* Note:		 	Only supports 40MHz PBCLOCK, UART1A and 
+*               {9600/115200},8,n,1 configuration
+* 
+********************************************************************/	
+int UartInit(uint64_t pbclock, uint32_t br)
+{
+   if(pbclock != 40000000L) 
+       return UART_PBCLOCK_NOT_SUP; // Todo: add support to common pbclock values.
+       
+   // In the following are used the table values provided in the datasheet
+   //PIC32MX Family Reference Manual, DS61107E-pages 21-14 and following
+ 	switch(br) {
+        case 115200:
+            U1ABRG=21; 
+            U1AMODEbits.BRGH = 0;
+            break;
+            
+        case 9600:
+            U1ABRG=259; 
+            U1AMODEbits.BRGH = 0;
+            break;
+        default:
+            return UART_BR_NOT_SUP; // Baudrate not supported
+    }
+    
+    // Common configuration settings
+    U1AMODEbits.SIDL=0; // Continue operation in idle mode 
+    U1AMODEbits.IREN=0; //Disable Irda
+    U1AMODEbits.UEN=0;  //Only use TX and RX pints. No HW flow control 
+    U1AMODEbits.WAKE=0;  //Wake -up on start bit disabled
+    U1AMODEbits.LPBACK=0;  //No loopback  
+    U1AMODEbits.ABAUD=0;  //No autobaud
+    U1AMODEbits.RXINV=0;  //Idle logic value is 1
+    U1AMODEbits.PDSEL=0;  //8 bit data, no parity
+    U1AMODEbits.STSEL=0;  //1 stop bit
+    U1STAbits.ADM_EN = 0; // No automatic address detection
+    U1STAbits.UTXISEL = 0; // Interrupt when TX buffer has at least 1 empty position
+    U1STAbits.UTXINV = 0; // Idle logic value is 1
+    
+    // TX ring, drained by the TX interrupt (enabled while not empty)
+    LfRingInit(&txRing, txBuf, UART_TX_BUF, 1);
+    IEC0CLR = _IEC0_U1TXIE_MASK;
+    IFS0CLR = _IFS0_U1TXIF_MASK;
+    IPC6bits.U1IP = UART_TX_IPL;
+    IPC6bits.U1IS = 0;
+    
+    // Configuration done. Enable.   
+    U1AMODEbits.ON = 1;  
+    U1STAbits.UTXEN = 1;
+    U1STAbits.URXEN = 1;
+    
+    return UART_SUCCESS;
+    
+}	
+
+
+/********************************************************************
+* Function: 	UartClose()
+* Precondition: 
+* Input: 		None
+* Output:		None.
+* Side Effects:	None.
+* Overview:     Closes UART connection.
+* Note:		 	No function currently
+********************************************************************/	
+int UartClose(void)
+{
+	//TODO: do some closing operation if required.	
+    return UART_SUCCESS;
+}	
+
+
+/********************************************************************
+* Function: 	GetChar()
+* Precondition: UART initialized
+* Input: 		None
+* Output:		UART_SUCESS: If there is some data
+ *              UART_FAIL: if there is no data.
+* Side Effects:	None.
+* Overview:     Gets the data from UART RX FIFO.
+* Note:		 	None.
+********************************************************************/
+int GetChar(uint8_t *byte)
+{
+	char dummy;
+
+	if(U1STAbits.OERR ||U1STAbits.FERR || U1STAbits.PERR) // receive errors?
+	{
+		dummy = U1RXREG; 			// dummy read to clear FERR/PERR
+		U1STAbits.OERR = 0;			// clear OERR to keep receiving
+	}
+
+	if(U1STAbits.URXDA)
+	{
+		*byte = U1ARXREG;		        // get data from UART RX FIFO
+		return UART_SUCCESS;
+	}
+	
+	return UART_FAIL;
+
+}
+
+
+/********************************************************************
+* Function: 	UartTxIsr()
+* Precondition: UART Initialized
+* Input: 		None
+* Output:		None
+* Side Effects:	None.
+* Overview:     TX interrupt: moves the ring to the TX FIFO until one
+*               of them is full/empty. Disables itself once the ring
+*               is empty.
+* Note:		 	No kernel calls, so it needs no FreeRTOS wrapper.
+*               IPL must match UART_TX_IPL.
+********************************************************************/
+void __ISR(_UART_1_VECTOR, IPL1SOFT) UartTxIsr(void)
+{
+    uint8_t txChar;
+
+    while(!U1STAbits.UTXBF && LfRingPop(&txRing, &txChar) == 0)
+        U1ATXREG = txChar;
+    if(LfRingFree(&txRing) == UART_TX_BUF)
+        IEC0CLR = _IEC0_U1TXIE_MASK;
+    IFS0CLR = _IFS0_U1TXIF_MASK;
+}
+
+/* Queues what fits, in a critical section. Returns the bytes queued */
+static uint32_t TxPush(const uint8_t *buf, uint32_t len)
+{
+    uint32_t n, used;
+
+    for(n = 0; n < len && LfRingPush(&txRing, &buf[n]) == 0; n++);
+    used = UART_TX_BUF - LfRingFree(&txRing);
+    if(used > txStats.peak)
+        txStats.peak = used;
+    txStats.queued += n;
+    if(n > 0)
+        IEC0SET = _IEC0_U1TXIE_MASK; // TX interrupt drains the ring
+    return n;
+}
+
+/********************************************************************
+* Function: 	UartTxEnqueue()
+* Precondition: UART Initialized
+* Input: 		Buffer and its length
+* Output:		UART_SUCCESS if all was queued
+*               UART_FAIL if bytes were dropped (see UartTxPolicy())
+* Side Effects:	None.
+* Overview:     Queues the data for transmission by the TX interrupt.
+*               Does not wait, except with UART_TX_WAIT and the ring full.
+* Note:		 	Safe from any task: one caller at a time in the ring.
+*               Before the scheduler starts the interrupt is masked, so
+*               the data waits in the ring (UART_TX_WAIT would hang).
+********************************************************************/
+int UartTxEnqueue(const uint8_t *buf, uint32_t len)
+{
+    uint32_t n = 0;
+    int ret = UART_SUCCESS;
+
+    taskENTER_CRITICAL();
+    if(txPolicy != UART_TX_DROP || LfRingFree(&txRing) >= len)
+        n = TxPush(buf, len);
+    if(n < len && txPolicy != UART_TX_WAIT) {
+        txStats.dropped += len - n;
+        txStats.drops++;
+        ret = UART_FAIL;
+    }
+    taskEXIT_CRITICAL();
+
+    if(txPolicy == UART_TX_WAIT) {
+        while(n < len) {
+            while(LfRingFree(&txRing) == 0); // wait for the TX interrupt
+            taskENTER_CRITICAL();
+            n += TxPush(buf + n, len - n);
+            taskEXIT_CRITICAL();
+        }
+    }
+    return ret;
+}
+
+/********************************************************************
+* Function: 	UartTxPolicy()
+* Precondition: None
+* Input: 		UART_TX_DROP, UART_TX_TRUNCATE or UART_TX_WAIT
+* Output:		Previous policy, UART_FAIL if unknown
+* Side Effects:	None.
+* Overview:     Sets what UartTxEnqueue() does when the ring is full.
+* Note:		 	None.
+********************************************************************/
+int UartTxPolicy(int policy)
+{
+    int old = txPolicy;
+
+    if(policy != UART_TX_DROP && policy != UART_TX_TRUNCATE && policy != UART_TX_WAIT)
+        return UART_FAIL;
+    txPolicy = policy;
+    return old;
+}
+
+/********************************************************************
+* Function: 	UartTxStats()
+* Precondition: None
+* Input: 		Where to copy the counters
+* Output:		None
+* Side Effects:	None.
+* Overview:     Counters of the TX ring since UartInit().
+* Note:		 	None.
+********************************************************************/
+void UartTxStats(struct uart_tx_stats *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = txStats;
+    taskEXIT_CRITICAL();
+}
+
+/********************************************************************
+* Function: 	UartTxPending()
+* Precondition: UART Initialized
+* Input: 		None
+* Output:		Bytes in the ring, not yet in the TX FIFO
+* Side Effects:	None.
+* Overview:     0 once the TX interrupt has taken all the data.
+* Note:		 	None.
+********************************************************************/
+uint32_t UartTxPending(void)
+{
+    return UART_TX_BUF - LfRingFree(&txRing);
+}
+
+/********************************************************************
+* Function: 	PutChar()
+* Precondition: UART Initialized
+* Input: 		Character
+* Output:		None
+* Side Effects:	None.
+* Overview:     Queues the data for transmission (UartTxEnqueue()).
+* Note:		 	None.
+********************************************************************/
+void PutChar(uint8_t txChar)
+{
+    UartTxEnqueue(&txChar, 1);
+}
+
+/********************************************************************
+* Function: 	PrintStr()
+* Precondition: UART Initialized
+* Input: 		NULL terminated string 
+* Output:		None
+* Side Effects:	None.
+* Overview:     Prints the input string.
+* Note:		 	Queued as a whole (UartTxEnqueue()), so with
+*               UART_TX_DROP a message is either sent or dropped.
+********************************************************************/
+void PrintStr(uint8_t *txStr)
+{
+    UartTxEnqueue(txStr, strlen((char *) txStr));
+}
+
+/***************************************End Of File*************************************/
+
+
@@ -0,0 +1,62 @@
+/* 
+ * File:   uart.h
+ * Author: Paulo Pedreiras
+ *
+ * Created on Jan 28, 2019
+ * MPLAB X IDE v5.10 + XC32 v2.15
+ *
+ * Target: Digilent chipKIT MAx32 board 
+ * 
+ * Overview:
+ *          Set of functions to handle the UART       
+ 
+ * Notes: Partially based on the bootloader code from Microchip
+ * 
+ * Revisions:
+ *      2017-10-25: initial release
+ *      2019-01-28: update to MPLAB X IDE v5.\0 + XC32 v2.15
+ */
+
+#ifndef __UART_H__
+#define __UART_H__
+
+#include <stdint.h>
+
+// Define return codes
+#define UART_SUCCESS 0
+#define UART_FAIL -1
+#define UART_BR_NOT_SUP -2
+#define UART_PBCLOCK_NOT_SUP -3
+
+// TX ring buffer, drained by the TX interrupt (power of 2)
+#ifndef UART_TX_BUF
+#define UART_TX_BUF 512
+#endif
+#define UART_TX_IPL 1 // TX interrupt priority (no kernel calls in it)
+
+// TX overflow policies (ring full)
+#define UART_TX_DROP 0      // Drop the whole string/char that does not fit (default)
+#define UART_TX_TRUNCATE 1  // Queue what fits, drop the rest
+#define UART_TX_WAIT 2      // Busy-wait for room, as the unbuffered driver
+
+// TX counters
+struct uart_tx_stats {
+    uint32_t queued;        // Bytes queued
+    uint32_t dropped;       // Bytes dropped
+    uint32_t drops;         // Calls that dropped bytes
+    uint32_t peak;          // Highest ring use (bytes)
+};
+
+// Define prototypes (public interface)
+int UartInit(uint64_t pbclock, uint32_t br);
+int UartClose(void);
+int GetChar(uint8_t *byte);
+void PutChar(uint8_t txChar);
+void PrintStr(uint8_t *txStr);
+int UartTxEnqueue(const uint8_t *buf, uint32_t len);
+int UartTxPolicy(int policy);
+void UartTxStats(struct uart_tx_stats *stats);
+uint32_t UartTxPending(void);
+
+
+#endif
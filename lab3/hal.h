@@ -0,0 +1,54 @@
+/*
+ * Miguel Cabral 93091
+ * Diogo Vicente 93262
+ *
+ * Hardware abstraction of the ChipKit MAX32 peripherals used by the lab3
+ * applications: LEDs LD4/LD5, ADC (AN0) and the console UART.
+ * - hal_pic32.c: the board (PIC32MX795F512L registers)
+ * - sim/hal_sim.c: the FreeRTOS POSIX simulator (see sim/Makefile), with the
+ *   ADC fed from a waveform file, the UART written to a file or pipe and the
+ *   LED changes timestamped. The ADC interrupt is a task of the highest
+ *   priority
+ * The applications only use these functions, so the same source builds for
+ * both.
+ */
+
+#ifndef __HAL_H__
+#define __HAL_H__
+
+#include <stdint.h>
+
+/* LEDs */
+#define HAL_LED_LD4         0   // RA3
+#define HAL_LED_LD5         1   // RC1
+#define HAL_LEDS            2
+
+/* Free-running clock: the core timer (SYSCLK/2) */
+#define HAL_CLOCK_HZ        40000000UL
+#define HAL_CLOCK_TO_US(c)  ((c) / (HAL_CLOCK_HZ / 1000000UL))
+
+/* ADC */
+#define HAL_ADC_MAX         1023    // 10-bit result, 0..3.3 V
+#define HAL_ADC_SAMPLES_MAX 16      // Conversions per start in interrupt mode (ADC1BUF0..F)
+#define HAL_ADC_IPL         2       // EOC interrupt priority, within the kernel's (1..configMAX_SYSCALL_INTERRUPT_PRIORITY)
+
+/* End of conversion callback, in interrupt context: the samples of one start
+ * and HalClock() at the interrupt. Returns pdTRUE if a FromISR call woke a
+ * higher priority task (the HAL then switches to it on return) */
+typedef int (*HalAdcIsr)(const uint16_t *samples, int n, uint32_t clock);
+
+void HalLedInit(void);                  // Outputs, off
+void HalLedSet(int led, int on);
+void HalLedToggle(int led);
+
+void HalAdcInit(void);                  // AN0, one conversion per start, end of conversion polled
+void HalAdcStart(void);
+int HalAdcDone(void);                   // 1 once the conversion ended
+uint16_t HalAdcRead(void);              // Result of the last conversion
+void HalAdcIntInit(int samples, HalAdcIsr isr); // AN0, `samples` conversions per HalAdcStart() (SMPI), then the EOC interrupt calls isr
+
+int HalConsoleInit(uint32_t baud);      // UART1A, stdout redirected to it. Returns UART_SUCCESS or the UartInit error
+
+uint32_t HalClock(void);                // HAL_CLOCK_HZ ticks, wraps around: use unsigned differences (< 107 s)
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * Miguel Cabral 93091
+ * Diogo Vicente 93262
+ *
+ * Hardware abstraction (hal.h) on the ChipKit MAX32 board.
+ * The register settings are the ones the applications used directly.
+ */
+
+#include <xc.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "hal.h"
+#include "../UART/uart.h"
+
+void HalLedInit(void)
+{
+    // Set RA3 (LD4) and RC1 (LD5) as outputs
+    TRISAbits.TRISA3 = 0;
+    TRISCbits.TRISC1 = 0;
+    PORTAbits.RA3 = 0;
+    PORTCbits.RC1 = 0;
+}
+
+void HalLedSet(int led, int on)
+{
+    if (led == HAL_LED_LD4)
+        PORTAbits.RA3 = on ? 1 : 0;
+    else if (led == HAL_LED_LD5)
+        PORTCbits.RC1 = on ? 1 : 0;
+}
+
+void HalLedToggle(int led)
+{
+    if (led == HAL_LED_LD4)
+        PORTAbits.RA3 = !PORTAbits.RA3;
+    else if (led == HAL_LED_LD5)
+        PORTCbits.RC1 = !PORTCbits.RC1;
+}
+
+void HalAdcInit(void)
+{
+    // Disable JTAG interface as it uses a few ADC ports
+    DDPCONbits.JTAGEN = 0;
+
+    // Initialize ADC module
+    // Polling mode, AN0 as input
+    // Generic part
+    AD1CON1bits.SSRC = 7; // Internal counter ends sampling and starts conversion
+    AD1CON1bits.CLRASAM = 1; //Stop conversion when 1st A/D converter interrupt is generated and clears ASAM bit automatically
+    AD1CON1bits.FORM = 0; // Integer 16 bit output format
+    AD1CON2bits.VCFG = 0; // VR+=AVdd; VR-=AVss
+    AD1CON2bits.SMPI = 0; // Number (+1) of consecutive conversions, stored in ADC1BUF0...ADCBUF{SMPI}
+    AD1CON3bits.ADRC = 1; // ADC uses internal RC clock
+    AD1CON3bits.SAMC = 16; // Sample time is 16TAD ( TAD = 100ns)
+    // Set AN0 as input
+    AD1CHSbits.CH0SA = 0; // Select AN0 as input for A/D converter
+    TRISBbits.TRISB0 = 1; // Set AN0 to input mode
+    AD1PCFGbits.PCFG0 = 0; // Set AN0 to analog mode
+    // Enable module
+    AD1CON1bits.ON = 1; // Enable A/D module (This must be the ***last instruction of configuration phase***)
+}
+
+void HalAdcStart(void)
+{
+    IFS1bits.AD1IF = 0; // Reset interrupt flag
+    AD1CON1bits.ASAM = 1; // Start conversion
+}
+
+int HalAdcDone(void)
+{
+    return IFS1bits.AD1IF;
+}
+
+uint16_t HalAdcRead(void)
+{
+    return ADC1BUF0;
+}
+
+/* EOC interrupt: hal_pic32_isr.S saves the task context, so that the
+ * callback can wake a task, and calls HalAdcIntHandler() */
+void __attribute__( (interrupt(IPL2AUTO), vector(_ADC_VECTOR))) vHalAdcIsrWrapper( void );
+
+static HalAdcIsr adc_isr;
+static int adc_samples;
+
+void HalAdcIntInit(int samples, HalAdcIsr isr)
+{
+    if (samples < 1)
+        samples = 1;
+    if (samples > HAL_ADC_SAMPLES_MAX)
+        samples = HAL_ADC_SAMPLES_MAX;
+    adc_samples = samples;
+    adc_isr = isr;
+
+    HalAdcInit();
+    AD1CON1bits.ON = 0; // Disable A/D module while it is reconfigured
+    AD1CON2bits.SMPI = samples - 1; // Interrupt after `samples` conversions (ASAM restarts sampling until then)
+    IPC6bits.AD1IP = HAL_ADC_IPL; // Must match the IPL of vHalAdcIsrWrapper
+    IPC6bits.AD1IS = 0;
+    IFS1bits.AD1IF = 0;
+    IEC1bits.AD1IE = 1; // Enable EOC interrupt
+    AD1CON1bits.ON = 1;
+}
+
+void HalAdcIntHandler(void)
+{
+    uint32_t clock = _CP0_GET_COUNT();
+    uint16_t buf[HAL_ADC_SAMPLES_MAX];
+    volatile unsigned int *res = &ADC1BUF0;
+    int i;
+
+    for (i = 0; i < adc_samples; i++)
+        buf[i] = res[4 * i]; // ADC1BUF0..ADC1BUFF are 16 bytes apart
+    IFS1bits.AD1IF = 0;
+    portEND_SWITCHING_ISR(adc_isr(buf, adc_samples, clock));
+}
+
+int HalConsoleInit(uint32_t baud)
+{
+    int err;
+
+    err = UartInit(configPERIPHERAL_CLOCK_HZ, baud);
+    if (err == UART_SUCCESS)
+        __XC_UART = 1; /* Redirect stdin/stdout/stderr to UART1*/
+    return err;
+}
+
+uint32_t HalClock(void)
+{
+    return _CP0_GET_COUNT();
+}
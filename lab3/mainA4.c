@@ -0,0 +1,261 @@
+/*
+ * Paulo Pedreiras
+ * Miguel Cabral
+ * Diogo Vicente, Sept/2021
+ *
+ * FREERTOS demo for ChipKit MAX32 board
+ * - Creates two periodic tasks
+ * - One toggles Led LD4, other is a long (interfering)task that 
+ *      activates LD5 when executing 
+ * - When the interfering task has higher priority interference becomes visible
+ *      - LD4 does not blink at the right rate
+ *
+ * Environment:
+ * - MPLAB X IDE v5.45
+ * - XC32 V2.50
+ * - FreeRTOS V202107.00
+ *
+ *
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+#include "hal.h"
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+
+/* App includes */
+#include "../UART/uart.h"
+#include "semphr.h" 
+#include "queue.h"
+#include "../common/filter.h"
+#include "tstat.h"
+
+/* Set the tasks' period (in system ticks) */
+#define LED_FLASH_PERIOD_MS 	( 250 / portTICK_RATE_MS ) 
+#define INTERF_PERIOD_MS 	( 3000 / portTICK_RATE_MS )
+#define ACQ_PERIOD_MS     (100 / portTICK_RATE_MS)
+
+/* Control the load task execution time (# of iterations)*/
+/* Each unit corresponds to approx 50 ms*/
+#define INTERF_WORKLOAD          ( 20)
+
+/* Priorities of the demo application tasks (high numb. -> high prio.) */
+#define PROC_PRIORITY	( tskIDLE_PRIORITY + 1)
+#define OUT_PRIORITY	    ( tskIDLE_PRIORITY + 2)
+#define ACQ_PRIORITY	    ( tskIDLE_PRIORITY + 3)
+
+/* Conversions per acquisition (SMPI + 1), averaged in the EOC interrupt */
+#define ADC_SAMPLES         4
+/* Longest wait for the EOC interrupt (ticks) */
+#define ADC_TIMEOUT         ( 2 )
+/* Acquisition timing printed every STATS_EVERY outputs */
+#define STATS_EVERY         50
+
+/* Average of the last AVG_WINDOW temperatures */
+#define AVG_WINDOW          5
+
+/* Global variables*/
+QueueHandle_t xQueue1, xQueue2;
+
+/* EOC interrupt -> vDataAqc: the sample is the notification value */
+static TaskHandle_t xAcqTask;
+static volatile uint32_t acq_eoc;   // HalClock() at the EOC interrupt
+static uint32_t adc_timeouts = 0;   // No interrupt within ADC_TIMEOUT
+static uint32_t samples_lost = 0;   // xQueue1 full (vDataProc late)
+static struct tstat acq_latency;    // EOC interrupt to vDataAqc running
+static struct tstat acq_cpu;        // vDataAqc execution per sample
+
+
+
+/*
+ * Prototypes and tasks
+ */
+
+/* EOC interrupt: average of the conversions to vDataAqc */
+static int AcqAdcIsr(const uint16_t *samples, int n, uint32_t clock)
+{
+    BaseType_t xWoken = pdFALSE;
+    uint32_t sum = 0;
+    int i;
+
+    for (i = 0; i < n; i++)
+        sum += samples[i];
+    acq_eoc = clock;
+    xTaskNotifyFromISR(xAcqTask, sum / n, eSetValueWithOverwrite, &xWoken);
+    return xWoken;
+}
+
+void vDataAqc(void *pvParam)
+{
+    
+   
+     // Variable declarations;
+    float temp;
+    uint32_t sample, start, cpu;
+    TickType_t xLastWakeTime;
+    xLastWakeTime = xTaskGetTickCount();
+    const TickType_t xFrequency = portTICK_PERIOD_MS*(ACQ_PERIOD_MS);
+   
+    if(xQueue1 != 0){
+    // Main loop
+        while (1) {
+            vTaskDelayUntil(&xLastWakeTime,xFrequency);
+            // Get one sample: start the conversions and block until the EOC interrupt
+            start = HalClock();
+            xTaskNotifyStateClear(NULL);    // Late EOC of a timed out conversion
+            HalAdcStart();
+            cpu = HalClock() - start;
+            if (xTaskNotifyWait(0, 0, &sample, ADC_TIMEOUT) != pdTRUE) {
+                adc_timeouts++;
+                continue;
+            }
+            start = HalClock();
+            TstatRecord(&acq_latency, start - acq_eoc);
+
+            // Convert to 0..3.3V 
+            temp = (sample * 3.3) / 1023;
+            temp = (temp * 100) / 3.3;
+           
+            // Output result
+            //sprintf(msg,"Voltage: %f\n\r",res);
+            //PrintStr(msg); 
+            //printf("Temp:%f",(res-2.7315)/.01); // For a LM335 directly connected
+            if (xQueueSend(xQueue1, (void*) &temp, ( TickType_t ) 0 ) != pdPASS)
+                samples_lost++;
+            TstatRecord(&acq_cpu, cpu + HalClock() - start);
+
+        }
+    }
+
+}
+ 
+
+void vDataProc(void *pvParam)
+{
+    int32_t window[AVG_WINDOW]; // Temperatures in 0.01 units
+    struct filter_ma ma;
+    float res;
+    int avg;
+    FilterMaInit(&ma, window, AVG_WINDOW);
+    if( xQueue1 != 0 && xQueue2 != 0 ){
+        while(1){
+           
+            if(xQueue1 != 0){
+                
+                if( xQueuePeek( xQueue1, &( res ), ( TickType_t ) 10 ) ){
+                 
+                    avg = (FilterMa(&ma, (int32_t) (res * 100 + 0.5f)) + 50) / 100;
+                    /* We have finished accessing the shared resource.  Reset the
+                    Queue. */
+                    xQueueReset(xQueue1);
+                       
+                    xQueueSend(xQueue2, (void*) &avg, ( TickType_t ) 0 );
+                    
+                }
+                else{
+                   //Failed to peek the message after 10 ticks
+                }        
+            }
+            
+        }
+          
+    } 
+}
+
+void vDataConvert(void *pvParam)
+{
+    uint8_t msg [80];
+    int avg, jobs = 0;
+    uint32_t timeouts, lost;
+    struct tstat latency, cpu;
+    struct uart_tx_stats tx;
+    if( xQueue2 != 0 )
+    {
+        while(1){
+          
+           if( xQueuePeek( xQueue2, &( avg ), ( TickType_t ) 10 ) ){
+            
+                
+                sprintf(msg,"AERAGE OF LAST 5 TEMPERATURE SAMPLES: %d\n\r",avg);
+                PrintStr(msg);  
+                xQueueReset(xQueue2);            
+                if (++jobs % STATS_EVERY == 0) {
+                    taskENTER_CRITICAL();
+                    latency = acq_latency;
+                    cpu = acq_cpu;
+                    timeouts = adc_timeouts;
+                    lost = samples_lost;
+                    taskEXIT_CRITICAL();
+                    TstatFormat(msg, sizeof(msg), &latency, "EOC to Acq");
+                    PrintStr(msg);
+                    TstatFormat(msg, sizeof(msg), &cpu, "Acq CPU");
+                    PrintStr(msg);
+                    sprintf(msg, "ADC: %lu timeouts, %lu samples lost\n\r", (unsigned long) timeouts, (unsigned long) lost);
+                    PrintStr(msg);
+                    UartTxStats(&tx);
+                    sprintf(msg, "UART TX: %lu bytes dropped in %lu messages\n\r", (unsigned long) tx.dropped, (unsigned long) tx.drops);
+                    PrintStr(msg);
+                }
+          
+            }
+            else
+            {
+                //Failed to peek the message after 10 ticks
+            }
+        }
+    }
+ 
+}
+
+
+/*
+ * Create the demo tasks then start the scheduler.
+ */
+int mainA4( void )
+{
+    
+    // LD4 and LD5 as outputs, off
+    HalLedInit();
+    
+    
+	// Init UART and redirect stdin/stdot/stderr to UART
+    if(HalConsoleInit(115200) != UART_SUCCESS) {
+        HalLedSet(HAL_LED_LD4, 1); // If Led active error initializing UART
+        while(1);
+    }
+    
+       
+    // ADC on AN0, ADC_SAMPLES conversions per start, EOC interrupt (hal.h)
+    HalAdcIntInit(ADC_SAMPLES, AcqAdcIsr);
+    TstatInit(&acq_latency);
+    TstatInit(&acq_cpu);
+   
+    
+    /* Welcome message*/
+    printf("\n\n *********************************************\n\r");
+    printf("Starting Temperature Acquisition FreeRTOS Demo - A4 APP \n\r");
+    printf("*********************************************\n\r");
+    
+    // Queues
+    
+    xQueue1 = xQueueCreate(1,sizeof(float));
+    xQueue2 = xQueueCreate(1,sizeof(int));
+      
+    /* Create the tasks defined within this file. */
+	
+    xTaskCreate( vDataAqc, ( const signed char * const ) "Acq", configMINIMAL_STACK_SIZE, NULL, ACQ_PRIORITY, &xAcqTask );
+    xTaskCreate( vDataProc, ( const signed char * const ) "Proc", configMINIMAL_STACK_SIZE, NULL, PROC_PRIORITY, NULL );
+    xTaskCreate( vDataConvert, ( const signed char * const ) "Out", configMINIMAL_STACK_SIZE, NULL, OUT_PRIORITY, NULL );
+        /* Finally start the scheduler. */
+	vTaskStartScheduler();
+
+	/* Will only reach here if there is insufficient heap available to start
+	the scheduler. */
+	return 0;
+}
@@ -20,7 +20,7 @@
 #include <stdio.h>
 #include <string.h>
 
-#include <xc.h>
+#include "hal.h"
 
 /* Kernel includes. */
 #include "FreeRTOS.h"
@@ -52,7 +52,7 @@ void pvLedFlash(void *pvParam)
     uint8_t mesg[80];
     
     for(;;) {
-        PORTAbits.RA3 = !PORTAbits.RA3;
+        HalLedToggle(HAL_LED_LD4);
         sprintf(mesg,"Task LedFlash (job %d)\n\r",iTaskTicks++);
         PrintStr(mesg);
         vTaskDelay(LED_FLASH_PERIOD_MS);        
@@ -71,7 +71,7 @@ void vLedFlash(void *pvParam)
     for(;;) {
               
         vTaskDelayUntil(&xLastWakeTime,xFrequency);
-        PORTAbits.RA3 = !PORTAbits.RA3;
+        HalLedToggle(HAL_LED_LD4);
         sprintf(mesg,"Task LedFlash (job %d)\n\r",iTaskTicks++);
         PrintStr(mesg); 
        
@@ -91,7 +91,7 @@ void vInterfTask(void *pvParam)
     xLastWakeTime = xTaskGetTickCount();  
     for(;;) {       
         vTaskDelayUntil(&xLastWakeTime,xFrequency);
-        PORTCbits.RC1 = 1;        
+        HalLedSet(HAL_LED_LD5, 1);        
         PrintStr("Interfering task release ...");
         
         /* Workload. In this case just spend CPU time ...*/        
@@ -100,7 +100,7 @@ void vInterfTask(void *pvParam)
             x=x/3;                
 
         PrintStr("and termination!\n\r");
-        PORTCbits.RC1 = 0;        
+        HalLedSet(HAL_LED_LD5, 0);        
          
        
     }
@@ -113,7 +113,7 @@ void pvInterfTask(void *pvParam)
     float x=100.1;
             
     for(;;) {
-        PORTCbits.RC1 = 1;        
+        HalLedSet(HAL_LED_LD5, 1);        
         PrintStr("Interfering task release ...");
         
         /* Workload. In this case just spend CPU time ...*/        
@@ -122,7 +122,7 @@ void pvInterfTask(void *pvParam)
             x=x/3;                
 
         PrintStr("and termination!\n\r");
-        PORTCbits.RC1 = 0;        
+        HalLedSet(HAL_LED_LD5, 0);        
         
         vTaskDelay(INTERF_PERIOD_MS);         
     }
@@ -135,19 +135,14 @@ void pvInterfTask(void *pvParam)
 int mainSetrLedBlink( void )
 {
     
-    // Set RA3 (LD4) and RC1 (LD5) as outputs
-    TRISAbits.TRISA3 = 0;
-    TRISCbits.TRISC1 = 0;
-    PORTAbits.RA3 = 0;
-    PORTCbits.RC1 = 0;
+    // LD4 and LD5 as outputs, off
+    HalLedInit();
 
 	// Init UART and redirect stdin/stdot/stderr to UART
-    if(UartInit(configPERIPHERAL_CLOCK_HZ, 115200) != UART_SUCCESS) {
-        PORTAbits.RA3 = 1; // If Led active error initializing UART
+    if(HalConsoleInit(115200) != UART_SUCCESS) {
+        HalLedSet(HAL_LED_LD4, 1); // If Led active error initializing UART
         while(1);
     }
-
-     __XC_UART = 1; /* Redirect stdin/stdout/stderr to UART1*/
     
     /* Welcome message*/
     printf("\n\n *********************************************\n\r");
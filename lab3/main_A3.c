@@ -20,7 +20,7 @@
 #include <stdio.h>
 #include <string.h>
 
-#include <xc.h>
+#include "hal.h"
 
 /* Kernel includes. */
 #include "FreeRTOS.h"
@@ -30,6 +30,9 @@
 /* App includes */
 #include "../UART/uart.h"
 #include <semphr.h>
+#include "../common/lockfree.h"
+#include "../common/filter.h"
+#include "tstat.h"
 
 /* Set the tasks' period (in system ticks) */
 #define PERIODIC_TASK_MS 	( 100 / portTICK_RATE_MS )
@@ -44,24 +47,61 @@
 #define PROC_PRIORITY	    ( tskIDLE_PRIORITY + 2 )
 #define OUT_PRIORITY	    ( tskIDLE_PRIORITY + 1 )
 
+/* Samples buffered between acquisition and processing (power of 2) */
+#define SAMPLE_RING         8
+
+/* Mean of the last MEAN_WINDOW samples, output every MEAN_WINDOW samples */
+#define MEAN_WINDOW         5
+
+/* Conversions per acquisition (SMPI + 1), averaged in the EOC interrupt */
+#define ADC_SAMPLES         4
+/* Longest wait for the EOC interrupt (ticks) */
+#define ADC_TIMEOUT         ( 2 )
+/* Acquisition timing printed every STATS_EVERY outputs */
+#define STATS_EVERY         10
+
 /*
  * Global Variables
  */
 SemaphoreHandle_t Sem1;
 SemaphoreHandle_t Sem2;
 
-int x1, x2 = 0;
+/* Data between the tasks, lock-free (the semaphores only wake up the consumer) */
+struct lf_ring samples;             // vAcqTask -> vProcTask, every sample
+int sample_buf[SAMPLE_RING];
+uint32_t samples_lost = 0;          // Ring full (vProcTask late)
+struct lf_triple mean;              // vProcTask -> vOutTask, last mean
+int mean_buf[3];
+
+/* EOC interrupt -> vAcqTask: the sample is the notification value */
+static TaskHandle_t acq_task;
+static volatile uint32_t acq_eoc;   // HalClock() at the EOC interrupt
+static uint32_t adc_timeouts = 0;   // No interrupt within ADC_TIMEOUT
+static struct tstat acq_latency;    // EOC interrupt to vAcqTask running
+static struct tstat acq_cpu;        // vAcqTask execution per sample
 
 /*
  * Prototypes and tasks
  */
 
+/* EOC interrupt: average of the conversions to vAcqTask */
+static int AcqAdcIsr(const uint16_t *samples, int n, uint32_t clock)
+{
+    BaseType_t xWoken = pdFALSE;
+    uint32_t sum = 0;
+    int i;
+
+    for (i = 0; i < n; i++)
+        sum += samples[i];
+    acq_eoc = clock;
+    xTaskNotifyFromISR(acq_task, sum / n, eSetValueWithOverwrite, &xWoken);
+    return xWoken;
+}
+
 void vAcqTask(void *pvParam)
 {
-    uint8_t mesg[80];
-    
-    
-    int iTaskTicks, res = 0;
+    int res = 0, x1;
+    uint32_t sample, start, cpu;
     TickType_t xLastWakeTime;
     const TickType_t xFrequency = pdMS_TO_TICKS(PERIODIC_TASK_MS);
     
@@ -69,35 +109,46 @@ void vAcqTask(void *pvParam)
     for(;;) {
         vTaskDelayUntil(&xLastWakeTime, xFrequency);
         
-        // Get one sample
-        IFS1bits.AD1IF = 0; // Reset interrupt flag
-        AD1CON1bits.ASAM = 1; // Start conversion
-        while (IFS1bits.AD1IF == 0); // Wait fo EOC
+        // Get one sample: start the conversions and block until the EOC interrupt
+        start = HalClock();
+        xTaskNotifyStateClear(NULL);    // Late EOC of a timed out conversion
+        HalAdcStart();
+        cpu = HalClock() - start;
+        if (xTaskNotifyWait(0, 0, &sample, ADC_TIMEOUT) != pdTRUE) {
+            adc_timeouts++;
+            continue;
+        }
+        start = HalClock();
+        TstatRecord(&acq_latency, start - acq_eoc);
 
         // Convert to 0..3.3V 
-        res = (ADC1BUF0 * 3.3) / 1023;
+        res = (sample * 3.3) / 1023;
         x1 = (res * 100) / 3.3; 
+        if (LfRingPush(&samples, &x1) != 0)
+            samples_lost++;
         xSemaphoreGive(Sem1);
+        TstatRecord(&acq_cpu, cpu + HalClock() - start);
     }
 }
 
 void vProcTask(void *pvParam)
 {
-    int val[5] = {0};
+    int32_t window[MEAN_WINDOW];
+    struct filter_ma ma;
+    int val, avg;
     int i = 0;
     
-    
-    uint8_t mesg[80];
+    FilterMaInit(&ma, window, MEAN_WINDOW);
     for(;;) {
         if (xSemaphoreTake(Sem1, ( TickType_t ) 10 ) == pdTRUE) {
-            val[i] = x1;
-            
-            if (i == 4) {
-                x2 = (val[0] + val[1] + val[2] + val[3] + val[4]) / 5;
-                i = 0;
-                xSemaphoreGive(Sem2);
-            } else {
-                i++;
+            while (LfRingPop(&samples, &val) == 0) {
+                avg = FilterMa(&ma, val);
+                if (++i == MEAN_WINDOW) {
+                    mean_buf[LfTripleBack(&mean)] = avg;
+                    LfTriplePublish(&mean);
+                    i = 0;
+                    xSemaphoreGive(Sem2);
+                }
             }
         }
     }
@@ -106,12 +157,34 @@ void vProcTask(void *pvParam)
 void vOutTask(void *pvParam)
 {
     uint8_t mesg[80];
+    int x2, jobs = 0;
+    uint32_t timeouts, lost;
+    struct tstat latency, cpu;
+    struct uart_tx_stats tx;
     
     for(;;) {
         if (xSemaphoreTake(Sem2, ( TickType_t ) 10 ) == pdTRUE) {
+        x2 = mean_buf[LfTripleRead(&mean, NULL)];
         sprintf(mesg,"Task Out (job)\n\r Mean Temp: %d\n\r", x2);
         
         PrintStr(mesg);     
+        if (++jobs % STATS_EVERY == 0) {
+            taskENTER_CRITICAL();
+            latency = acq_latency;
+            cpu = acq_cpu;
+            timeouts = adc_timeouts;
+            lost = samples_lost;
+            taskEXIT_CRITICAL();
+            TstatFormat(mesg, sizeof(mesg), &latency, "EOC to Acq");
+            PrintStr(mesg);
+            TstatFormat(mesg, sizeof(mesg), &cpu, "Acq CPU");
+            PrintStr(mesg);
+            sprintf(mesg, "ADC: %lu timeouts, %lu samples lost\n\r", (unsigned long) timeouts, (unsigned long) lost);
+            PrintStr(mesg);
+            UartTxStats(&tx);
+            sprintf(mesg, "UART TX: %lu bytes dropped in %lu messages\n\r", (unsigned long) tx.dropped, (unsigned long) tx.drops);
+            PrintStr(mesg);
+        }
         }
     }
 }
@@ -122,41 +195,26 @@ void vOutTask(void *pvParam)
 int main_A3( void )
 {
     
-    // Disable JTAG interface as it uses a few ADC ports
-    DDPCONbits.JTAGEN = 0;
-    
-    // Initialize ADC module
-    // Polling mode, AN0 as input
-    // Generic part
-    AD1CON1bits.SSRC = 7; // Internal counter ends sampling and starts conversion
-    AD1CON1bits.CLRASAM = 1; //Stop conversion when 1st A/D converter interrupt is generated and clears ASAM bit automatically
-    AD1CON1bits.FORM = 0; // Integer 16 bit output format
-    AD1CON2bits.VCFG = 0; // VR+=AVdd; VR-=AVss
-    AD1CON2bits.SMPI = 0; // Number (+1) of consecutive conversions, stored in ADC1BUF0...ADCBUF{SMPI}
-    AD1CON3bits.ADRC = 1; // ADC uses internal RC clock
-    AD1CON3bits.SAMC = 16; // Sample time is 16TAD ( TAD = 100ns)
-    // Set AN0 as input
-    AD1CHSbits.CH0SA = 0; // Select AN0 as input for A/D converter
-    TRISBbits.TRISB0 = 1; // Set AN0 to input mode
-    AD1PCFGbits.PCFG0 = 0; // Set AN0 to analog mode
-    // Enable module
-    AD1CON1bits.ON = 1; // Enable A/D module (This must be the ***last instruction of configuration phase***)
+    // ADC on AN0, ADC_SAMPLES conversions per start, EOC interrupt (hal.h)
+    HalAdcIntInit(ADC_SAMPLES, AcqAdcIsr);
+    TstatInit(&acq_latency);
+    TstatInit(&acq_cpu);
 
     
     Sem1 = xSemaphoreCreateBinary();
     Sem2 = xSemaphoreCreateBinary();
+    LfRingInit(&samples, sample_buf, SAMPLE_RING, sizeof(int));
+    LfTripleInit(&mean);
 
 	// Init UART and redirect stdin/stdot/stderr to UART
-    if(UartInit(configPERIPHERAL_CLOCK_HZ, 115200) != UART_SUCCESS) {
-        PORTAbits.RA3 = 1; // If Led active error initializing UART
+    if(HalConsoleInit(115200) != UART_SUCCESS) {
+        HalLedSet(HAL_LED_LD4, 1); // If Led active error initializing UART
         while(1);
     }
-
-     __XC_UART = 1; /* Redirect stdin/stdout/stderr to UART1*/
     
 
     /* Create the tasks defined within this file. */
-	xTaskCreate( vAcqTask, ( const signed char * const ) "Acquisition", configMINIMAL_STACK_SIZE, NULL, ACQ_PRIORITY, NULL );
+	xTaskCreate( vAcqTask, ( const signed char * const ) "Acquisition", configMINIMAL_STACK_SIZE, NULL, ACQ_PRIORITY, &acq_task );
     xTaskCreate( vProcTask, ( const signed char * const ) "Processing", configMINIMAL_STACK_SIZE, NULL, PROC_PRIORITY, NULL );
     xTaskCreate( vOutTask, ( const signed char * const ) "Out", configMINIMAL_STACK_SIZE, NULL, OUT_PRIORITY, NULL );
     
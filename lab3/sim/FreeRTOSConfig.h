@@ -0,0 +1,79 @@
+/*
+ * Miguel Cabral 93091
+ * Diogo Vicente 93262
+ *
+ * FreeRTOS configuration of the lab3 simulator (FreeRTOS POSIX port).
+ * Same tick, priorities and API set as the board (../FreeRTOSConfig.h), so
+ * the applications run unchanged. The differences are the ones of the port:
+ * each task is a pthread (stacks of at least PTHREAD_STACK_MIN), the heap is
+ * malloc (heap_3.c) and there is no interrupt priority. The execution time
+ * of each task is measured by the simulator from the context switches
+ * (traceTASK_SWITCHED_IN, see hal_sim.h).
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <limits.h>
+
+/*-----------------------------------------------------------
+ * Application specific definitions.
+ *
+ * See http://www.freertos.org/a00110.html
+ *----------------------------------------------------------*/
+
+#define configUSE_PREEMPTION					1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION	0
+#define configUSE_IDLE_HOOK						0
+#define configUSE_TICK_HOOK						0
+#define configTICK_RATE_HZ						( ( TickType_t ) 1000 )
+#define configCPU_CLOCK_HZ						( 80000000UL )	// Of the board (UartInit checks the PB clock)
+#define configPERIPHERAL_CLOCK_HZ				( 40000000UL )
+#define configMAX_PRIORITIES					( 5UL )
+#define configMINIMAL_STACK_SIZE				( ( unsigned long ) PTHREAD_STACK_MIN )
+#define configSTACK_DEPTH_TYPE					uint32_t	// PTHREAD_STACK_MIN may not fit 16 bits
+#define configTOTAL_HEAP_SIZE					( ( size_t ) 0 )	// heap_3: malloc
+#define configMAX_TASK_NAME_LEN					( 8 )
+#define configUSE_TRACE_FACILITY				1
+#define configUSE_16_BIT_TICKS					0
+#define configIDLE_SHOULD_YIELD					1
+#define configUSE_MUTEXES						1
+#define configCHECK_FOR_STACK_OVERFLOW			0
+#define configQUEUE_REGISTRY_SIZE				0
+#define configUSE_RECURSIVE_MUTEXES				1
+#define configUSE_MALLOC_FAILED_HOOK			1
+#define configUSE_APPLICATION_TASK_TAG			0
+#define configUSE_COUNTING_SEMAPHORES			1
+#define configGENERATE_RUN_TIME_STATS			0
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES 			0
+#define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
+
+/* Software timer definitions. */
+#define configUSE_TIMERS				1
+#define configTIMER_TASK_PRIORITY		( 2 )
+#define configTIMER_QUEUE_LENGTH		5
+#define configTIMER_TASK_STACK_DEPTH	( configMINIMAL_STACK_SIZE * 2 )
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function. */
+
+#define INCLUDE_vTaskPrioritySet			1
+#define INCLUDE_uxTaskPriorityGet			1
+#define INCLUDE_vTaskDelete					1
+#define INCLUDE_vTaskCleanUpResources		0
+#define INCLUDE_vTaskSuspend				1
+#define INCLUDE_vTaskDelayUntil				1
+#define INCLUDE_vTaskDelay					1
+#define INCLUDE_uxTaskGetStackHighWaterMark	1
+#define INCLUDE_eTaskGetState				1
+
+void vAssertCalled( const char *pcFileName, unsigned long ulLine );
+#define configASSERT( x ) if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+/* Execution time per task (hal_sim.c) */
+void vSimTaskSwitchedIn( void *pxTask );
+#define traceTASK_SWITCHED_IN() vSimTaskSwitchedIn( ( void * ) pxCurrentTCB )
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,285 @@
+/*
+ * Miguel Cabral 93091
+ * Diogo Vicente 93262
+ *
+ * Simulated board of the lab3 simulator (see hal_sim.h)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "../hal.h"
+#include "../UART/uart.h"
+#include "../../common/hist.h"
+#include "hal_sim.h"
+
+static uint64_t t0;                 // CLOCK_MONOTONIC at HalSimInit() (ns)
+
+/* LEDs */
+static const char *led_name[HAL_LEDS] = { "LD4", "LD5" };
+static int led_state[HAL_LEDS];
+static uint64_t led_changed[HAL_LEDS];      // Last change (ns), 0 if none
+static unsigned long led_changes[HAL_LEDS];
+static struct hist led_period[HAL_LEDS];    // Between changes to on (ns)
+static struct hist led_on[HAL_LEDS];        // On time (ns)
+static uint64_t led_rise[HAL_LEDS];         // Last change to on (ns), 0 if none
+static FILE *led_log;
+
+/* ADC */
+static uint16_t *adc_wave;          // SIM_ADC_FILE, NULL for the sine
+static unsigned long adc_len, adc_next;
+static uint64_t adc_start;          // Start of the conversion (ns), 0 if none
+static uint16_t adc_result;
+static unsigned long adc_conversions;
+static struct hist adc_wait;        // Start to end of the conversions seen by the task or ISR (ns)
+static HalAdcIsr adc_isr;           // Interrupt mode (HalAdcIntInit)
+static int adc_samples;
+static TaskHandle_t adc_task;       // Runs adc_isr
+
+/* Execution time per task, charged at each context switch */
+static struct {
+    void *task;
+    uint64_t ns;
+    unsigned long switches;
+} exec[SIM_TASKS_MAX];
+static int exec_tasks, exec_running = -1;
+static uint64_t exec_since;
+
+uint64_t HalSimNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec - t0;
+}
+
+void HalSimInit(void)
+{
+    const char *path;
+    FILE *f;
+    unsigned v;
+    int i;
+
+    t0 = 0;
+    t0 = HalSimNs();
+    for (i = 0; i < HAL_LEDS; i++) {
+        HistInit(&led_period[i]);
+        HistInit(&led_on[i]);
+    }
+    HistInit(&adc_wait);
+
+    path = getenv("SIM_LED_FILE");
+    if (path != NULL && (led_log = fopen(path, "w")) == NULL)
+        perror(path);
+
+    path = getenv("SIM_ADC_FILE");
+    if (path == NULL)
+        return;
+    if ((f = fopen(path, "r")) == NULL) {
+        perror(path);
+        exit(1);
+    }
+    adc_wave = malloc(SIM_ADC_SAMPLES_MAX * sizeof(uint16_t));
+    while (adc_len < SIM_ADC_SAMPLES_MAX && fscanf(f, "%u", &v) == 1)
+        adc_wave[adc_len++] = v > HAL_ADC_MAX ? HAL_ADC_MAX : v;
+    fclose(f);
+    if (adc_len == 0) {
+        fprintf(stderr, "%s: no samples\n", path);
+        exit(1);
+    }
+}
+
+/* ***********************************************
+* LEDs
+* ***********************************************/
+void HalLedInit(void)
+{
+    HalLedSet(HAL_LED_LD4, 0);
+    HalLedSet(HAL_LED_LD5, 0);
+}
+
+void HalLedSet(int led, int on)
+{
+    uint64_t now = HalSimNs();
+
+    if (led < 0 || led >= HAL_LEDS || led_state[led] == !!on)
+        return;
+    led_state[led] = !!on;
+    led_changes[led]++;
+    if (on) {
+        if (led_rise[led])
+            HistRecord(&led_period[led], now - led_rise[led]);
+        led_rise[led] = now;
+    } else if (led_rise[led])
+        HistRecord(&led_on[led], now - led_rise[led]);
+    led_changed[led] = now;
+    if (led_log != NULL) {
+        taskENTER_CRITICAL();       // See PutChar()
+        fprintf(led_log, "%llu.%09llu %s %d\n", (unsigned long long) (now / 1000000000ULL),
+            (unsigned long long) (now % 1000000000ULL), led_name[led], led_state[led]);
+        taskEXIT_CRITICAL();
+    }
+}
+
+void HalLedToggle(int led)
+{
+    if (led >= 0 && led < HAL_LEDS)
+        HalLedSet(led, !led_state[led]);
+}
+
+/* ***********************************************
+* ADC
+* ***********************************************/
+void HalAdcInit(void)
+{
+    adc_start = 0;
+}
+
+static uint16_t AdcConvert(uint64_t now)
+{
+    uint16_t v;
+
+    if (adc_wave != NULL) {
+        v = adc_wave[adc_next];
+        adc_next = (adc_next + 1) % adc_len;
+    } else
+        v = (HAL_ADC_MAX + 1) / 2 + 200 * sin(2 * M_PI * now / 10e9);
+    adc_conversions++;
+    return v;
+}
+
+void HalAdcStart(void)
+{
+    adc_start = HalSimNs();
+    if (adc_isr != NULL)
+        xTaskNotifyGive(adc_task);
+    else
+        adc_result = AdcConvert(adc_start);
+}
+
+int HalAdcDone(void)
+{
+    uint64_t now = HalSimNs();
+
+    if (adc_start == 0)
+        return 1;
+    if (now - adc_start < SIM_ADC_CONV_NS)
+        return 0;
+    HistRecord(&adc_wait, now - adc_start);
+    adc_start = 0;
+    return 1;
+}
+
+uint16_t HalAdcRead(void)
+{
+    return adc_result;
+}
+
+/* The EOC interrupt: a task above all the others that waits for the
+ * conversions (busy, so its execution time includes them) and calls the
+ * callback as the board's interrupt would, masked */
+static void prvAdcIsr(void *pvParam)
+{
+    uint16_t buf[HAL_ADC_SAMPLES_MAX];
+    int i, woken;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        for (i = 0; i < adc_samples; i++) {
+            while (HalSimNs() - adc_start < (uint64_t) (i + 1) * SIM_ADC_CONV_NS);
+            buf[i] = AdcConvert(HalSimNs());
+        }
+        HistRecord(&adc_wait, HalSimNs() - adc_start);
+        taskENTER_CRITICAL();
+        woken = adc_isr(buf, adc_samples, HalClock());
+        taskEXIT_CRITICAL();
+        if (woken)
+            taskYIELD();
+    }
+}
+
+void HalAdcIntInit(int samples, HalAdcIsr isr)
+{
+    if (samples < 1)
+        samples = 1;
+    if (samples > HAL_ADC_SAMPLES_MAX)
+        samples = HAL_ADC_SAMPLES_MAX;
+    adc_samples = samples;
+    adc_isr = isr;
+    xTaskCreate(prvAdcIsr, "ADC ISR", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, &adc_task);
+}
+
+/* ***********************************************
+* Console and clock
+* ***********************************************/
+int HalConsoleInit(uint32_t baud)
+{
+    return UartInit(configPERIPHERAL_CLOCK_HZ, baud);
+}
+
+uint32_t HalClock(void)
+{
+    return (uint32_t) (HalSimNs() / (1000000000ULL / HAL_CLOCK_HZ));
+}
+
+/* ***********************************************
+* Execution time per task
+* ***********************************************/
+void vSimTaskSwitchedIn(void *pxTask)
+{
+    uint64_t now = HalSimNs();
+    int i;
+
+    if (exec_running >= 0)
+        exec[exec_running].ns += now - exec_since;
+    exec_since = now;
+    for (i = 0; i < exec_tasks && exec[i].task != pxTask; i++);
+    if (i == exec_tasks) {
+        if (exec_tasks == SIM_TASKS_MAX) {
+            exec_running = -1;
+            return;
+        }
+        exec[exec_tasks++].task = pxTask;
+    }
+    exec[i].switches++;
+    exec_running = i;
+}
+
+void HalSimReport(void)
+{
+    uint64_t now = HalSimNs(), total = 0;
+    char label[40];
+    int i;
+
+    if (exec_running >= 0) {
+        exec[exec_running].ns += now - exec_since;
+        exec_since = now;
+    }
+    for (i = 0; i < exec_tasks; i++)
+        total += exec[i].ns;
+    printf("Simulated %.3f s\n", now / 1e9);
+    printf("%-10s %12s %8s %10s\n", "Task", "Exec (ms)", "CPU (%)", "Switches");
+    for (i = 0; i < exec_tasks; i++)
+        printf("%-10s %12.3f %8.2f %10lu\n", pcTaskGetName((TaskHandle_t) exec[i].task), exec[i].ns / 1e6,
+            total ? 100.0 * exec[i].ns / total : 0, exec[i].switches);
+
+    for (i = 0; i < HAL_LEDS; i++) {
+        printf("%s: %lu changes\n", led_name[i], led_changes[i]);
+        snprintf(label, sizeof(label), "  %s period", led_name[i]);
+        HistPrint(&led_period[i], label);
+        snprintf(label, sizeof(label), "  %s on time", led_name[i]);
+        HistPrint(&led_on[i], label);
+    }
+    printf("ADC: %lu conversions\n", adc_conversions);
+    HistPrint(&adc_wait, "  ADC conversion wait");
+    UartSimReport();
+    if (led_log != NULL)
+        fflush(led_log);
+    fflush(stdout);
+}
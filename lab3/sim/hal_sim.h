@@ -0,0 +1,38 @@
+/*
+ * Miguel Cabral 93091
+ * Diogo Vicente 93262
+ *
+ * Simulated board of the lab3 simulator (implements ../hal.h).
+ * Configured from the environment:
+ * - SIM_ADC_FILE: waveform fed to the ADC, one 10-bit value (0..1023) per
+ *   line, one line per conversion, restarted at the end. Without it the ADC
+ *   reads a 10 s sine around mid-scale
+ * - SIM_UART_FILE: file or pipe (mkfifo) the UART writes to, stdout if not
+ *   set. printf() stays on stdout, with the report at the end
+ * - SIM_LED_FILE: log of the LED changes, "seconds LED state" per line
+ * The UART sends at the configured baud rate through the TX ring and an
+ * 8-byte TX FIFO, with the overflow policy of the board (see uart_sim.c),
+ * and the ADC conversion takes SIM_ADC_CONV_NS. The ADC interrupt (HalAdcIntInit) is the "ADC ISR" task,
+ * of the highest priority, so its time shows in the report.
+ * Time is CLOCK_MONOTONIC since HalSimInit().
+ */
+
+#ifndef __HAL_SIM_H__
+#define __HAL_SIM_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define SIM_ADC_CONV_NS     2800    // Sampling (16 TAD) + conversion (12 TAD), TAD = 100 ns
+#define SIM_ADC_SAMPLES_MAX 65536   // Values read from SIM_ADC_FILE
+#define SIM_UART_FIFO       8       // TX FIFO depth (bytes)
+#define SIM_TASKS_MAX       16      // Tasks with execution time accounting
+
+void HalSimInit(void);
+uint64_t HalSimNs(void);            // ns since HalSimInit()
+void HalSimReport(void);            // LEDs, ADC, UART and CPU time per task, to stdout
+
+/* UART model (uart_sim.c) */
+void UartSimReport(void);
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Miguel Cabral 93091
+ * Diogo Vicente 93262
+ *
+ * Entry point of the lab3 simulator: runs one of the board applications on
+ * the FreeRTOS POSIX port for a number of seconds, then prints the report
+ * of the simulated board (hal_sim.h).
+ * Usage: ./sim APP [SECONDS]
+ *   APP: a3 (main_A3.c), a4 (mainA4.c) or blink (mainSETRLedBlink.c)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "hal_sim.h"
+
+#define SIM_SECONDS_DEFAULT 10
+#define SIM_MONITOR_PRIO    ( configMAX_PRIORITIES - 1 )
+
+int main_A3( void );
+int mainA4( void );
+int mainSetrLedBlink( void );
+
+static const struct {
+    const char *name;
+    int (*entry)( void );
+} apps[] = {
+    { "a3", main_A3 },
+    { "a4", mainA4 },
+    { "blink", mainSetrLedBlink },
+};
+
+/* Stops the simulation after the run time (pvParam, in seconds) */
+static void prvMonitor( void *pvParam )
+{
+    TickType_t xRun = ( TickType_t ) ( uintptr_t ) pvParam * configTICK_RATE_HZ;
+
+    vTaskDelay( xRun );
+    vTaskSuspendAll();
+    HalSimReport();
+    exit( 0 );
+}
+
+int main( int argc, char *argv[] )
+{
+    unsigned long seconds = SIM_SECONDS_DEFAULT;
+    size_t i;
+
+    for (i = 0; argc > 1 && i < sizeof(apps) / sizeof(apps[0]); i++)
+        if (strcmp(argv[1], apps[i].name) == 0)
+            break;
+    if (argc < 2 || argc > 3 || i == sizeof(apps) / sizeof(apps[0]) ||
+        (argc == 3 && (seconds = strtoul(argv[2], NULL, 10)) == 0)) {
+        fprintf(stderr, "Usage: %s a3|a4|blink [SECONDS]\n", argv[0]);
+        return 1;
+    }
+
+    HalSimInit();
+    xTaskCreate( prvMonitor, "Monitor", configMINIMAL_STACK_SIZE, ( void * ) ( uintptr_t ) seconds, SIM_MONITOR_PRIO, NULL );
+
+    /* Creates the tasks and starts the scheduler */
+    apps[i].entry();
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationMallocFailedHook( void )
+{
+    fprintf( stderr, "Out of memory\n" );
+    abort();
+}
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char *pcFileName, unsigned long ulLine )
+{
+    fprintf( stderr, "Assertion failed at %s:%lu\n", pcFileName, ulLine );
+    abort();
+}
@@ -0,0 +1,166 @@
+/*
+ * Miguel Cabral 93091
+ * Diogo Vicente 93262
+ *
+ * UART (../UART/uart.h) of the lab3 simulator. The bytes go to
+ * SIM_UART_FILE (stdout if not set) and leave at the baud rate, 10 bits per
+ * byte, through the TX ring (UART_TX_BUF) and the TX FIFO. The fill level
+ * is computed from the time, so the TX interrupt needs no thread: the
+ * overflow policies, the counters and the UART_TX_WAIT busy-wait behave as
+ * on the board.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "../UART/uart.h"
+#include "hal_sim.h"
+
+#define TX_SPACE (UART_TX_BUF + SIM_UART_FIFO)
+
+static FILE *tx;
+static uint64_t byte_ns;            // Time on the line of one byte
+static uint64_t tx_empty;           // When the ring and FIFO become empty (ns)
+static int tx_policy = UART_TX_DROP;
+static struct uart_tx_stats tx_stats;
+static uint64_t tx_wait;            // Busy-waiting with UART_TX_WAIT (ns)
+
+int UartInit(uint64_t pbclock, uint32_t br)
+{
+    const char *path;
+
+    if (pbclock != 40000000L)
+        return UART_PBCLOCK_NOT_SUP;
+    if (br != 115200 && br != 9600)
+        return UART_BR_NOT_SUP;
+    byte_ns = 10 * 1000000000ULL / br;
+
+    tx = stdout;
+    path = getenv("SIM_UART_FILE");
+    if (path != NULL && (tx = fopen(path, "w")) == NULL) {
+        perror(path);
+        return UART_FAIL;
+    }
+    return UART_SUCCESS;
+}
+
+int UartClose(void)
+{
+    if (tx != NULL && tx != stdout)
+        fclose(tx);
+    tx = NULL;
+    return UART_SUCCESS;
+}
+
+int GetChar(uint8_t *byte)
+{
+    (void) byte;
+    return UART_FAIL;               // Nothing is ever received
+}
+
+/* Bytes in the ring and FIFO at now */
+static uint32_t TxUsed(uint64_t now)
+{
+    return tx_empty > now ? (tx_empty - now + byte_ns - 1) / byte_ns : 0;
+}
+
+/* Queues what fits, in a critical section. Returns the bytes queued */
+static uint32_t TxPush(const uint8_t *buf, uint32_t len)
+{
+    uint64_t now = HalSimNs();
+    uint32_t used = TxUsed(now), n = len;
+
+    if (n > TX_SPACE - used)
+        n = TX_SPACE - used;
+    if (n == 0)
+        return 0;
+    tx_empty = (tx_empty > now ? tx_empty : now) + n * byte_ns;
+    if (used + n > tx_stats.peak)
+        tx_stats.peak = used + n > UART_TX_BUF ? UART_TX_BUF : used + n;
+    tx_stats.queued += n;
+    // In the critical section: no preemption inside stdio, it would block
+    // the next task using it
+    fwrite(buf, 1, n, tx);
+    if (memchr(buf, '\n', n) != NULL)
+        fflush(tx);
+    return n;
+}
+
+int UartTxEnqueue(const uint8_t *buf, uint32_t len)
+{
+    uint64_t start;
+    uint32_t n = 0;
+    int ret = UART_SUCCESS;
+
+    if (tx == NULL)
+        return UART_FAIL;
+    taskENTER_CRITICAL();
+    if (tx_policy != UART_TX_DROP || TX_SPACE - TxUsed(HalSimNs()) >= len)
+        n = TxPush(buf, len);
+    if (n < len && tx_policy != UART_TX_WAIT) {
+        tx_stats.dropped += len - n;
+        tx_stats.drops++;
+        ret = UART_FAIL;
+    }
+    taskEXIT_CRITICAL();
+
+    if (tx_policy == UART_TX_WAIT) {
+        while (n < len) {
+            start = HalSimNs();
+            while (TxUsed(HalSimNs()) == TX_SPACE);
+            tx_wait += HalSimNs() - start;
+            taskENTER_CRITICAL();
+            n += TxPush(buf + n, len - n);
+            taskEXIT_CRITICAL();
+        }
+    }
+    return ret;
+}
+
+int UartTxPolicy(int policy)
+{
+    int old = tx_policy;
+
+    if (policy != UART_TX_DROP && policy != UART_TX_TRUNCATE && policy != UART_TX_WAIT)
+        return UART_FAIL;
+    tx_policy = policy;
+    return old;
+}
+
+void UartTxStats(struct uart_tx_stats *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = tx_stats;
+    taskEXIT_CRITICAL();
+}
+
+uint32_t UartTxPending(void)
+{
+    uint32_t used = TxUsed(HalSimNs());
+
+    return used > SIM_UART_FIFO ? used - SIM_UART_FIFO : 0;
+}
+
+void PutChar(uint8_t txChar)
+{
+    UartTxEnqueue(&txChar, 1);
+}
+
+void PrintStr(uint8_t *txStr)
+{
+    UartTxEnqueue(txStr, strlen((char *) txStr));
+}
+
+void UartSimReport(void)
+{
+    printf("UART: %lu bytes queued, %lu dropped in %lu calls, ring peak %lu/%d, %.3f ms busy-waiting\n",
+        (unsigned long) tx_stats.queued, (unsigned long) tx_stats.dropped, (unsigned long) tx_stats.drops,
+        (unsigned long) tx_stats.peak, UART_TX_BUF, tx_wait / 1e6);
+    if (tx != NULL)
+        fflush(tx);
+}
@@ -0,0 +1,51 @@
+/*
+ * Miguel Cabral 93091
+ * Diogo Vicente 93262
+ *
+ * Min/mean/max of a time measured with HalClock() (hal.h), small enough for
+ * the board: no buckets, no floating point. Formatted in us for PrintStr().
+ */
+
+#ifndef __TSTAT_H__
+#define __TSTAT_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "hal.h"
+
+struct tstat {
+    uint32_t n;
+    uint32_t min, max;          // HalClock() ticks
+    uint64_t sum;
+};
+
+static inline void TstatInit(struct tstat *t)
+{
+    t->n = 0;
+    t->min = UINT32_MAX;
+    t->max = 0;
+    t->sum = 0;
+}
+
+static inline void TstatRecord(struct tstat *t, uint32_t ticks)
+{
+    t->n++;
+    t->sum += ticks;
+    if (ticks < t->min)
+        t->min = ticks;
+    if (ticks > t->max)
+        t->max = ticks;
+}
+
+/* "label: n N min/mean/max A/B/C us\n\r" */
+static inline int TstatFormat(char *buf, size_t len, const struct tstat *t, const char *label)
+{
+    if (t->n == 0)
+        return snprintf(buf, len, "%s: no samples\n\r", label);
+    return snprintf(buf, len, "%s: n %u min/mean/max %u/%u/%u us\n\r", label, (unsigned) t->n,
+        (unsigned) HAL_CLOCK_TO_US(t->min), (unsigned) HAL_CLOCK_TO_US(t->sum / t->n),
+        (unsigned) HAL_CLOCK_TO_US(t->max));
+}
+
+#endif